@@ -0,0 +1,239 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include <dedup.h>
+#include <delaunay.h>
+#include <io.h>
+#include <parallel.h>
+#include <stream.h>
+#include <tiling.h>
+#include <trace.h>
+
+namespace {
+    void usage() {
+        std::fprintf(stderr,
+            "usage: delaunay-cli [options] <points>\n"
+            "\n"
+            "Triangulate a point file (.xyz/.csv/.txt, .ply or .las) and print\n"
+            "a timing breakdown.\n"
+            "\n"
+            "options:\n"
+            "  -o, --output <file>   write the mesh (.ply or .obj)\n"
+            "  -e, --engine <name>   bowyer-watson (default), tiled or streaming\n"
+            "  -t, --threads <n>     worker threads, 0 for all (default)\n"
+            "      --tiles <c>x<r>   tile grid for the tiled engine (default 4x4)\n"
+            "  -d, --dedup <tol>     merge points within tol of each other first\n"
+            "      --trace <file>    write a Chrome trace of the run\n");
+    }
+
+    class timer {
+    public:
+        timer(): start(std::chrono::steady_clock::now()) {}
+
+        // Seconds since the last lap
+        double lap() {
+            auto now = std::chrono::steady_clock::now();
+            double elapsed = std::chrono::duration<double>(now - start).count();
+            start = now;
+
+            return elapsed;
+        }
+
+    private:
+        std::chrono::steady_clock::time_point start;
+    };
+
+    void report(const char* phase, double seconds) {
+        std::printf("  %-12s %10.3f ms\n", phase, seconds * 1000.0);
+    }
+
+    void report(const delaunay::statistics& stats) {
+        std::printf("counters:\n");
+        std::printf("  %-22s %12llu\n", "incircle tests", (unsigned long long)stats.incircle_tests);
+        std::printf("  %-22s %12llu\n", "halfplane tests", (unsigned long long)stats.halfplane_tests);
+        std::printf("  %-22s %12llu\n", "boundary comparisons", (unsigned long long)stats.boundary_comparisons);
+        std::printf("  %-22s %12llu\n", "triangles created", (unsigned long long)stats.triangles_created);
+        std::printf("  %-22s %12llu\n", "triangles destroyed", (unsigned long long)stats.triangles_destroyed);
+        std::printf("  %-22s %12llu\n", "allocations", (unsigned long long)stats.allocations);
+
+        std::printf("cavity sizes:\n");
+        for(size_t i = 0; i < delaunay::statistics::buckets; ++i) {
+            if(!stats.cavity_sizes[i]) continue;
+
+            if(i == 0) std::printf("  %7s %12llu\n", "0", (unsigned long long)stats.cavity_sizes[i]);
+            else std::printf("  %6zu+ %12llu\n", size_t(1) << (i - 1), (unsigned long long)stats.cavity_sizes[i]);
+        }
+    }
+
+    // Points must be sorted by x
+    std::vector<triangle> streamed(const std::vector<point>& points) {
+        std::vector<triangle> triangles;
+        delaunay::streaming_triangulator stream([&](const triangle& t) {
+            triangles.push_back(t);
+        });
+
+        const size_t chunk = 1 << 14;
+        for(size_t i = 0; i < points.size(); i += chunk) {
+            size_t end = std::min(i + chunk, points.size());
+            stream.insert(std::vector<point>(points.begin() + i, points.begin() + end));
+
+            if(end < points.size()) stream.finalize(points[end].x);
+        }
+
+        stream.finish();
+        return triangles;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string input, output, trace, engine = "bowyer-watson";
+    unsigned threads = 0;
+    double tolerance = -1.0;
+    size_t columns = 4, rows = 4;
+
+    for(int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if((arg == "-o" || arg == "--output") && has_value) {
+            output = argv[++i];
+        } else if((arg == "-e" || arg == "--engine") && has_value) {
+            engine = argv[++i];
+        } else if((arg == "-t" || arg == "--threads") && has_value) {
+            threads = static_cast<unsigned>(std::stoul(argv[++i]));
+        } else if((arg == "-d" || arg == "--dedup") && has_value) {
+            tolerance = std::stod(argv[++i]);
+        } else if(arg == "--trace" && has_value) {
+            trace = argv[++i];
+        } else if(arg == "--tiles" && has_value) {
+            if(std::sscanf(argv[++i], "%zux%zu", &columns, &rows) != 2) {
+                usage();
+                return 1;
+            }
+        } else if(arg == "-h" || arg == "--help") {
+            usage();
+            return 0;
+        } else if(input.empty() && arg[0] != '-') {
+            input = arg;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    if(input.empty()) {
+        usage();
+        return 1;
+    }
+
+    try {
+        // Always installed: the library's own spans time its phases
+        delaunay::tracer tracer;
+        delaunay::tracer::install(&tracer);
+
+        timer clock;
+        std::vector<std::pair<const char*, double>> phases;
+
+        std::vector<point> points;
+        {
+            delaunay::trace_span span("load");
+            points = delaunay::read_points(input, threads);
+        }
+
+        phases.emplace_back("load", clock.lap());
+
+        size_t loaded = points.size();
+        if(tolerance >= 0.0) {
+            points = delaunay::deduplicate(points, tolerance).points;
+            phases.emplace_back("dedup", clock.lap());
+        }
+
+        delaunay::statistics stats;
+        std::vector<triangle> triangles;
+        mesh m;
+
+        if(engine == "bowyer-watson") {
+            // Indexed directly, with nothing to look up afterwards
+            m.vertices = points;
+            delaunay::triangulate(points, m.indices, m.hull, &stats);
+
+            double insert = tracer.seconds("insert");
+            double cleanup = tracer.seconds("cleanup");
+
+            // Bounds checks, the degenerate input test and the super triangle
+            phases.emplace_back("prepare", std::max(0.0, clock.lap() - insert - cleanup));
+            phases.emplace_back("insert", insert);
+            phases.emplace_back("cleanup", cleanup);
+        } else if(engine == "tiled") {
+            triangles = delaunay::triangulate_tiled(points, delaunay::tiling(columns, rows, 0.5, threads));
+            phases.emplace_back("triangulate", clock.lap());
+        } else if(engine == "streaming") {
+            std::vector<point> sorted(points.size());
+            {
+                delaunay::trace_span span("sort");
+
+                std::vector<uint64_t> keys(points.size());
+                std::vector<uint32_t> order(points.size());
+                for(size_t i = 0; i < points.size(); ++i) {
+                    keys[i] = delaunay::radix_key(points[i].x);
+                    order[i] = static_cast<uint32_t>(i);
+                }
+
+                delaunay::radix_sort(keys, order, threads);
+                for(size_t i = 0; i < order.size(); ++i) sorted[i] = points[order[i]];
+            }
+
+            phases.emplace_back("sort", clock.lap());
+
+            triangles = streamed(sorted);
+            phases.emplace_back("triangulate", clock.lap());
+        } else {
+            throw std::invalid_argument("unknown engine " + engine);
+        }
+
+        if(engine != "bowyer-watson") {
+            m = mesh(points, triangles);
+            phases.emplace_back("index", clock.lap());
+        }
+
+        if(!output.empty()) {
+            delaunay::trace_span span("write");
+            delaunay::write_mesh(m, output);
+            phases.emplace_back("write", clock.lap());
+        }
+
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+
+        std::printf("%zu points, %zu triangles (%s)\n", points.size(), m.size(), engine.c_str());
+        if(points.size() != loaded) std::printf("%zu duplicates merged\n", loaded - points.size());
+
+        double total = 0.0;
+        for(const auto& phase : phases) {
+            report(phase.first, phase.second);
+            total += phase.second;
+        }
+
+        report("total", total);
+
+        // ru_maxrss is reported in kilobytes on Linux
+        std::printf("  %-12s %10.1f MB\n", "peak rss", usage.ru_maxrss / 1024.0);
+
+        if(delaunay::statistics::enabled && engine == "bowyer-watson") report(stats);
+
+        delaunay::tracer::install(nullptr);
+        if(!trace.empty()) tracer.write(trace);
+    } catch(const std::exception& e) {
+        std::fprintf(stderr, "delaunay-cli: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,214 @@
+#include "alpha.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "parallel.h"
+#include "trace.h"
+
+namespace delaunay {
+    namespace {
+        // Triangles per unit of parallel work
+        const size_t chunk = 1 << 14;
+    }
+
+    alpha_complex::alpha_complex(const mesh_view& m, unsigned threads): m(m) {
+        trace_span span("alpha complex");
+
+        const double infinity = std::numeric_limits<double>::infinity();
+        const size_t count = m.size();
+
+        radii.resize(count);
+        parallel_for((count + chunk - 1) / chunk, threads, [&](size_t part) {
+            for(size_t t = part * chunk; t < std::min(count, (part + 1) * chunk); ++t) {
+                radii[t] = m.at(t).circumcircle().radius;
+            }
+        });
+
+        order.resize(count);
+        for(uint32_t t = 0; t < count; ++t) order[t] = t;
+
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return radii[a] < radii[b];
+        });
+
+        // Every edge once, from the triangle with the larger index
+        edges.reserve(count * 3 / 2 + 2);
+
+        for(uint32_t t = 0; t < count; ++t) {
+            for(uint32_t i = 0; i < 3; ++i) {
+                uint32_t slot = 3 * t + i;
+                uint32_t u = m.neighbors[slot];
+                if(u != mesh::none && u > t) continue;
+
+                uint32_t a = m.indices[slot], b = m.indices[3 * t + (i + 1) % 3];
+                point middle = point::midpoint(m.vertices[a], m.vertices[b]);
+                double half = m.vertices[a].distance_squared(m.vertices[b]) / 4.0;
+
+                // Attached: the opposite vertex of either triangle lies in the
+                // diametral circle, so the edge cannot come before it
+                bool attached = m.vertices[m.indices[3 * t + (i + 2) % 3]].distance_squared(middle) < half;
+                double other = infinity;
+
+                if(u != mesh::none) {
+                    uint32_t twin = m.corner(u, b);
+                    uint32_t opposite = m.indices[mesh::previous(twin)];
+
+                    attached |= m.vertices[opposite].distance_squared(middle) < half;
+                    other = radii[u];
+
+                    if(other < radii[t]) slot = twin;
+                }
+
+                double lower = std::min(radii[t], other), upper = std::max(radii[t], other);
+                edges.push_back(alpha_edge{ slot, attached ? lower : half, lower, upper });
+            }
+        }
+
+        std::sort(edges.begin(), edges.end(), [](const alpha_edge& a, const alpha_edge& b) {
+            return a.birth < b.birth;
+        });
+
+        std::vector<uint32_t> intervals;
+        for(uint32_t e = 0; e < edges.size(); ++e) {
+            if(edges[e].lower < edges[e].upper) intervals.push_back(e);
+        }
+
+        by_lower.reserve(intervals.size());
+        by_upper.reserve(intervals.size());
+        build(intervals);
+    }
+
+    uint32_t alpha_complex::build(std::vector<uint32_t>& intervals) {
+        if(intervals.empty()) return mesh::none;
+
+        /* Centering on the median lower end keeps at least that interval in
+        ** the node, and leaves at most half of them on either side.
+         */
+        std::vector<double> ends(intervals.size());
+        for(size_t i = 0; i < intervals.size(); ++i) ends[i] = edges[intervals[i]].lower;
+
+        std::nth_element(ends.begin(), ends.begin() + ends.size() / 2, ends.end());
+        double center = ends[ends.size() / 2];
+
+        std::vector<uint32_t> below, above;
+        uint32_t begin = static_cast<uint32_t>(by_lower.size());
+
+        for(uint32_t e : intervals) {
+            if(edges[e].upper <= center) {
+                below.push_back(e);
+            } else if(edges[e].lower > center) {
+                above.push_back(e);
+            } else {
+                by_lower.push_back(e);
+                by_upper.push_back(e);
+            }
+        }
+
+        uint32_t end = static_cast<uint32_t>(by_lower.size());
+
+        std::sort(by_lower.begin() + begin, by_lower.end(), [&](uint32_t a, uint32_t b) {
+            return edges[a].lower < edges[b].lower;
+        });
+
+        std::sort(by_upper.begin() + begin, by_upper.end(), [&](uint32_t a, uint32_t b) {
+            return edges[a].upper > edges[b].upper;
+        });
+
+        intervals.clear();
+        intervals.shrink_to_fit();
+
+        uint32_t index = static_cast<uint32_t>(nodes.size());
+        nodes.push_back(node{ center, begin, end, mesh::none, mesh::none });
+
+        uint32_t lower = build(below);
+        nodes[index].below = lower;
+
+        uint32_t upper = build(above);
+        nodes[index].above = upper;
+
+        return index;
+    }
+
+    size_t alpha_complex::triangle_count(double alpha) const {
+        return std::upper_bound(order.begin(), order.end(), alpha, [&](double a, uint32_t t) {
+            return a < radii[t];
+        }) - order.begin();
+    }
+
+    std::vector<uint32_t> alpha_complex::triangles(double alpha) const {
+        return std::vector<uint32_t>(order.begin(), order.begin() + triangle_count(alpha));
+    }
+
+    size_t alpha_complex::edge_count(double alpha) const {
+        return std::upper_bound(edges.begin(), edges.end(), alpha, [](double a, const alpha_edge& e) {
+            return a < e.birth;
+        }) - edges.begin();
+    }
+
+    std::vector<uint32_t> alpha_complex::boundary(double alpha) const {
+        std::vector<uint32_t> slots;
+
+        // Below the center, the node's intervals all reach past alpha; above,
+        // they all start before it. Hull edges bound the triangles for good.
+        const double infinity = std::numeric_limits<double>::infinity();
+
+        for(uint32_t n = nodes.empty() ? mesh::none : 0; n != mesh::none;) {
+            const node& x = nodes[n];
+
+            if(alpha < x.center) {
+                for(uint32_t i = x.begin; i < x.end && edges[by_lower[i]].lower <= alpha; ++i) {
+                    slots.push_back(edges[by_lower[i]].slot);
+                }
+
+                n = x.below;
+            } else {
+                for(uint32_t i = x.begin; i < x.end; ++i) {
+                    double upper = edges[by_upper[i]].upper;
+                    if(upper <= alpha && upper != infinity) break;
+
+                    slots.push_back(edges[by_upper[i]].slot);
+                }
+
+                n = x.above;
+            }
+        }
+
+        return slots;
+    }
+
+    std::vector<std::vector<uint32_t>> alpha_complex::polylines(double alpha) const {
+        std::vector<uint32_t> slots = boundary(alpha);
+        std::sort(slots.begin(), slots.end());
+
+        std::vector<uint8_t> chained(slots.size(), 0);
+        std::vector<std::vector<uint32_t>> rings;
+
+        for(size_t k = 0; k < slots.size(); ++k) {
+            if(chained[k]) continue;
+
+            std::vector<uint32_t> ring;
+            uint32_t slot = slots[k];
+
+            do {
+                chained[std::lower_bound(slots.begin(), slots.end(), slot) - slots.begin()] = 1;
+                ring.push_back(m.indices[slot]);
+
+                /* The next edge leaves the head of this one: turn clockwise
+                ** around the head through the triangles of the complex until
+                ** the edge leaving it has none on its other side. Staying in
+                ** one fan splits rings where shapes touch at a vertex.
+                 */
+                slot = mesh::next(slot);
+
+                for(uint32_t u = m.neighbors[slot]; u != mesh::none && radii[u] <= alpha; u = m.neighbors[slot]) {
+                    slot = m.corner(u, m.indices[slot]);
+                }
+            } while(slot != slots[k]);
+
+            rings.push_back(std::move(ring));
+        }
+
+        return rings;
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "mesh.h"
+
+namespace delaunay {
+    /*
+    ** An edge of a Delaunay triangulation with its alpha intervals. The edge
+    ** is named by its slot (slot 3 * t + i runs from vertex i to vertex
+    ** (i + 1) % 3 of triangle t, as in mesh::neighbors) in the triangle with
+    ** the smaller circumcircle. It joins the complex at `birth` and bounds
+    ** the triangles of the complex for alpha in [lower, upper).
+     */
+    class alpha_edge {
+    public:
+        uint32_t slot;
+        double birth, lower, upper;
+    };
+
+    /*
+    ** Alpha complex of a Delaunay triangulation for every alpha at once,
+    ** alpha being a squared radius: a triangle is in the complex from its
+    ** squared circumradius on, and an edge from half its squared length on,
+    ** unless a triangle vertex lies in its diametral circle, in which case
+    ** it joins with its first triangle. Every interval is computed once, so
+    ** each query costs time proportional to its output (plus a logarithmic
+    ** search), and alpha can be changed interactively.
+    **
+    ** The complex refers to the mesh, which must outlive it.
+     */
+    class alpha_complex {
+    public:
+        // Squared circumradius of every triangle
+        std::vector<double> radii;
+
+        // Triangles by increasing radius
+        std::vector<uint32_t> order;
+
+        // Every edge of the mesh, by increasing birth
+        std::vector<alpha_edge> edges;
+
+        explicit alpha_complex(const mesh_view& m, unsigned threads = 0);
+
+        // Triangles in the complex for alpha: a prefix of `order`
+        size_t triangle_count(double alpha) const;
+        std::vector<uint32_t> triangles(double alpha) const;
+
+        // Edges in the complex for alpha: a prefix of `edges`
+        size_t edge_count(double alpha) const;
+
+        // Slots of the boundary edges of the triangles in the complex,
+        // directed with the triangles on their left
+        std::vector<uint32_t> boundary(double alpha) const;
+
+        // Boundary edges chained into closed rings of vertex indices:
+        // counter-clockwise around shapes, clockwise around their holes
+        std::vector<std::vector<uint32_t>> polylines(double alpha) const;
+
+    private:
+        /* Centered interval tree over the boundary intervals: a node keeps
+        ** the intervals containing its center, sorted by lower and by upper
+        ** end, and the intervals entirely below or above it are in its
+        ** children.
+         */
+        class node {
+        public:
+            double center;
+            uint32_t begin, end;
+            uint32_t below, above;
+        };
+
+        mesh_view m;
+        std::vector<node> nodes;
+        std::vector<uint32_t> by_lower, by_upper;
+
+        uint32_t build(std::vector<uint32_t>& intervals);
+    };
+}
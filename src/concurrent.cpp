@@ -0,0 +1,104 @@
+#include "concurrent.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+#include "locate.h"
+#include "trace.h"
+
+namespace delaunay {
+    concurrent_mesh::reader::reader(std::atomic<uint64_t>* slot, const mesh* version):
+        slot(slot), version(version) {}
+
+    concurrent_mesh::reader::reader(reader&& other): slot(other.slot), version(other.version) {
+        other.slot = nullptr;
+    }
+
+    concurrent_mesh::reader::~reader() {
+        if(slot) slot->store(0, std::memory_order_release);
+    }
+
+    const mesh& concurrent_mesh::reader::operator*() const {
+        return *version;
+    }
+
+    const mesh* concurrent_mesh::reader::operator->() const {
+        return version;
+    }
+
+    concurrent_mesh::concurrent_mesh(mesh m, size_t readers):
+        slots(new slot[readers]), slot_count(readers), current(new mesh(std::move(m))), epoch(1) {
+        if(readers == 0) throw std::invalid_argument("expected at least one reader slot");
+    }
+
+    concurrent_mesh::~concurrent_mesh() {
+        delete current.load();
+        for(const auto& old : retired) delete old.first;
+    }
+
+    concurrent_mesh::reader concurrent_mesh::read() const {
+        /* Pin the epoch before loading the version: a writer that swapped
+        ** the version after this epoch was read either sees the pin, or
+        ** finished its swap before the pin, so the load below gets the new
+        ** version. Everything is sequentially consistent for that.
+         */
+        size_t start = std::hash<std::thread::id>()(std::this_thread::get_id()) % slot_count;
+
+        for(size_t tried = 0;; ++tried) {
+            std::atomic<uint64_t>& pin = slots[(start + tried) % slot_count].epoch;
+
+            uint64_t free = 0;
+            if(pin.load(std::memory_order_relaxed) == 0 && pin.compare_exchange_strong(free, epoch.load())) {
+                return reader(&pin, current.load());
+            }
+
+            if(tried % slot_count == slot_count - 1) std::this_thread::yield();
+        }
+    }
+
+    void concurrent_mesh::update(const std::function<void(mesh&)>& edit) {
+        std::lock_guard<std::mutex> guard(writer);
+
+        std::unique_ptr<mesh> next(new mesh(*current.load()));
+        edit(*next);
+
+        const mesh* old = current.exchange(next.release());
+        retired.emplace_back(old, ++epoch);
+
+        reclaim();
+    }
+
+    std::vector<uint32_t> concurrent_mesh::insert(const std::vector<point>& points, unsigned threads) {
+        trace_span span("concurrent insert");
+
+        std::vector<uint32_t> vertices;
+        update([&](mesh& m) {
+            vertices = delaunay::insert(m, points, threads);
+        });
+
+        return vertices;
+    }
+
+    uint64_t concurrent_mesh::version() const {
+        return epoch.load();
+    }
+
+    void concurrent_mesh::reclaim() {
+        uint64_t oldest = UINT64_MAX;
+        for(size_t i = 0; i < slot_count; ++i) {
+            uint64_t pinned = slots[i].epoch.load();
+            if(pinned) oldest = std::min(oldest, pinned);
+        }
+
+        // A version retired at epoch e is invisible to readers pinned at e or later
+        auto freed = std::remove_if(retired.begin(), retired.end(), [&](const std::pair<const mesh*, uint64_t>& old) {
+            if(old.second > oldest) return false;
+
+            delete old.first;
+            return true;
+        });
+
+        retired.erase(freed, retired.end());
+    }
+}
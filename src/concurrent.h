@@ -0,0 +1,83 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "geometry.h"
+#include "mesh.h"
+
+namespace delaunay {
+    /*
+    ** A mesh shared by many reading threads and occasional writers, in the
+    ** style of read-copy-update. A reader pins the current version with a
+    ** single compare-and-swap, without locks, and sees it unchanged for as
+    ** long as it holds it. Writers edit a private copy and publish it with
+    ** one atomic store, so no reader ever sees a half-applied change. A
+    ** replaced version is freed by a later write once every reader that
+    ** could still hold it is gone (epoch-based reclamation).
+    **
+    ** Every write copies the mesh, so edits are best batched.
+     */
+    class concurrent_mesh {
+    public:
+        // A pinned version; release it promptly so old versions can be freed
+        class reader {
+        public:
+            reader(reader&& other);
+            reader(const reader&) = delete;
+            reader& operator=(const reader&) = delete;
+            ~reader();
+
+            const mesh& operator*() const;
+            const mesh* operator->() const;
+
+        private:
+            friend class concurrent_mesh;
+            reader(std::atomic<uint64_t>* slot, const mesh* version);
+
+            std::atomic<uint64_t>* slot;
+            const mesh* version;
+        };
+
+        // At most `readers` readers are held at once; more wait for a free slot
+        explicit concurrent_mesh(mesh m, size_t readers = 256);
+        ~concurrent_mesh();
+
+        reader read() const;
+
+        // Apply `edit` to a copy of the current version and publish it
+        void update(const std::function<void(mesh&)>& edit);
+
+        // Insert points (see delaunay::insert) on `threads` threads as one new
+        // version and return their vertices
+        std::vector<uint32_t> insert(const std::vector<point>& points, unsigned threads = 0);
+
+        // Versions published so far, counting the first
+        uint64_t version() const;
+
+    private:
+        /* Epoch at which a reader pinned the current version, 0 while the
+        ** slot is free. Slots sit on their own cache lines so readers do not
+        ** contend.
+         */
+        class alignas(64) slot {
+        public:
+            std::atomic<uint64_t> epoch{0};
+        };
+
+        std::unique_ptr<slot[]> slots;
+        size_t slot_count;
+
+        std::atomic<const mesh*> current;
+        std::atomic<uint64_t> epoch;
+
+        // Replaced versions and the epoch from which no reader can see them
+        std::mutex writer;
+        std::vector<std::pair<const mesh*, uint64_t>> retired;
+
+        void reclaim();
+    };
+}
@@ -0,0 +1,135 @@
+#include "dedup.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "parallel.h"
+#include "trace.h"
+
+namespace delaunay {
+    namespace {
+        const uint32_t unassigned = UINT32_MAX;
+
+        class cell_key {
+        public:
+            double x, y;
+
+            bool operator<(const cell_key& other) const {
+                return x < other.x || (x == other.x && y < other.y);
+            }
+
+            bool operator==(const cell_key& other) const {
+                return x == other.x && y == other.y;
+            }
+        };
+    }
+
+    deduplication deduplicate(const std::vector<point>& points, double tolerance) {
+        if(!(tolerance >= 0.0)) throw std::invalid_argument("tolerance must not be negative");
+        if(points.size() > UINT32_MAX) throw std::length_error("too many points");
+
+        trace_span span("deduplicate");
+
+        const uint32_t n = static_cast<uint32_t>(points.size());
+
+        deduplication result;
+        result.representative.assign(n, unassigned);
+
+        // Every input point becomes distinct, or joins one that is
+        auto assign = [&](uint32_t i, uint32_t first) {
+            if(first == i) {
+                result.representative[i] = static_cast<uint32_t>(result.points.size());
+                result.points.push_back(points[i]);
+            } else {
+                result.representative[i] = result.representative[first];
+            }
+        };
+
+        std::vector<uint32_t> order(n);
+        for(uint32_t i = 0; i < n; ++i) order[i] = i;
+
+        if(tolerance == 0.0) {
+            // Exact duplicates are adjacent once sorted by y, then stably by
+            // x; ties keep input order
+            std::vector<uint64_t> sort_keys(n);
+            for(uint32_t i = 0; i < n; ++i) sort_keys[i] = radix_key(points[i].y);
+            radix_sort(sort_keys, order);
+
+            for(uint32_t k = 0; k < n; ++k) sort_keys[k] = radix_key(points[order[k]].x);
+            radix_sort(sort_keys, order);
+
+            std::vector<uint32_t> first(n);
+            for(size_t k = 0; k < order.size(); ++k) {
+                bool same = k > 0 && points[order[k]].x == points[order[k - 1]].x &&
+                                     points[order[k]].y == points[order[k - 1]].y;
+                first[order[k]] = same ? first[order[k - 1]] : order[k];
+            }
+
+            for(uint32_t i = 0; i < n; ++i) assign(i, first[i]);
+            return result;
+        }
+
+        /* Bucket the points into a grid of tolerance-sized cells by sorting
+        ** on the cell. A point can only be within reach of points in its own
+        ** or one of the 8 surrounding cells, and only of the distinct ones
+        ** before it in the input. Each cell chains its distinct points in
+        ** input order; they are pairwise out of reach, so a cell holds only
+        ** a few, however many duplicates pile up on them.
+         */
+        std::vector<cell_key> keys(n);
+        for(uint32_t i = 0; i < n; ++i) {
+            keys[i] = { std::floor(points[i].x / tolerance), std::floor(points[i].y / tolerance) };
+        }
+
+        std::vector<uint64_t> sort_keys(n);
+        for(uint32_t i = 0; i < n; ++i) sort_keys[i] = radix_key(keys[i].y);
+        radix_sort(sort_keys, order);
+
+        for(uint32_t k = 0; k < n; ++k) sort_keys[k] = radix_key(keys[order[k]].x);
+        radix_sort(sort_keys, order);
+
+        std::vector<cell_key> cells;
+        std::vector<uint32_t> cell_of(n);
+        for(uint32_t i : order) {
+            if(cells.empty() || !(cells.back() == keys[i])) cells.push_back(keys[i]);
+            cell_of[i] = static_cast<uint32_t>(cells.size() - 1);
+        }
+
+        std::vector<uint32_t> head(cells.size(), unassigned), tail(cells.size(), unassigned);
+        std::vector<uint32_t> next(n, unassigned);
+
+        double reach = tolerance * tolerance;
+
+        for(uint32_t i = 0; i < n; ++i) {
+            uint32_t first = i;
+
+            for(double dx = -1.0; dx <= 1.0; ++dx) {
+                for(double dy = -1.0; dy <= 1.0; ++dy) {
+                    cell_key key = { keys[i].x + dx, keys[i].y + dy };
+
+                    auto it = std::lower_bound(cells.begin(), cells.end(), key);
+                    if(it == cells.end() || !(*it == key)) continue;
+
+                    // Chains are in input order, so the first hit is the earliest
+                    for(uint32_t j = head[it - cells.begin()]; j < first; j = next[j]) {
+                        if(points[i].distance_squared(points[j]) <= reach) {
+                            first = j;
+                            break;
+                        }
+                    }
+                }
+            }
+
+            if(first == i) {
+                uint32_t c = cell_of[i];
+                (tail[c] == unassigned ? head[c] : next[tail[c]]) = i;
+                tail[c] = i;
+            }
+
+            assign(i, first);
+        }
+
+        return result;
+    }
+}
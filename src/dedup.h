@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "geometry.h"
+
+namespace delaunay {
+    class deduplication {
+    public:
+        // The distinct points, in order of their first occurrence
+        std::vector<point> points;
+
+        // For every input point, the index of its representative in `points`
+        std::vector<uint32_t> representative;
+    };
+
+    /*
+    ** Merge points that coincide, or lie within `tolerance` of an earlier
+    ** point, in O(n log n). With a tolerance, points are assigned greedily
+    ** in input order: a point joins the first earlier distinct point within
+    ** reach, so merged points are never chained further than `tolerance`
+    ** from their representative.
+    **
+    ** Triangulating `points` rather than the raw input avoids the degenerate
+    ** cavities duplicates produce; `representative` maps the result back.
+     */
+    deduplication deduplicate(const std::vector<point>& points, double tolerance = 0.0);
+}
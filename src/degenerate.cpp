@@ -0,0 +1,224 @@
+#include "degenerate.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace delaunay {
+    namespace {
+        // Relative tolerance for grid coordinates and cocircularity
+        const double grid_tolerance = 1e-9;
+        const double circle_tolerance = 64 * std::numeric_limits<double>::epsilon();
+
+        class layout {
+        public:
+            degeneracy kind = degeneracy::general;
+
+            // Collinear: two distinct points spanning the line
+            point from, to;
+
+            // Cocircular: the circle's center
+            point center;
+
+            // Grid: dimensions (the point at every node is kept apart)
+            uint32_t columns = 0, rows = 0;
+        };
+
+        // Fills `nodes` with the point at every node, row by row
+        bool grid(const std::vector<point>& points, layout& result, std::vector<uint32_t>& nodes) {
+            const uint32_t n = static_cast<uint32_t>(points.size());
+
+            double min_x = points[0].x, max_x = points[0].x;
+            double min_y = points[0].y, max_y = points[0].y;
+            for(const point& p : points) {
+                min_x = std::min(min_x, p.x);
+                max_x = std::max(max_x, p.x);
+                min_y = std::min(min_y, p.y);
+                max_y = std::max(max_y, p.y);
+            }
+
+            double width = max_x - min_x, height = max_y - min_y;
+            if(!(width > 0.0) || !(height > 0.0)) return false;
+
+            // The row of the first point gives the number of columns
+            uint32_t columns = 0;
+            for(const point& p : points) {
+                columns += std::fabs(p.y - points[0].y) <= grid_tolerance * height;
+            }
+
+            if(columns < 2 || n % columns != 0 || n / columns < 2) return false;
+            uint32_t rows = n / columns;
+
+            double step_x = width / (columns - 1), step_y = height / (rows - 1);
+
+            // Every point must sit on a distinct node
+            nodes.assign(n, UINT32_MAX);
+            for(uint32_t i = 0; i < n; ++i) {
+                double column = (points[i].x - min_x) / step_x;
+                double row = (points[i].y - min_y) / step_y;
+
+                double c = std::round(column), r = std::round(row);
+                if(std::fabs(column - c) > grid_tolerance || std::fabs(row - r) > grid_tolerance) return false;
+
+                uint32_t& node = nodes[static_cast<size_t>(r) * columns + static_cast<size_t>(c)];
+                if(node != UINT32_MAX) return false;
+                node = i;
+            }
+
+            result.kind = degeneracy::grid;
+            result.columns = columns;
+            result.rows = rows;
+
+            return true;
+        }
+
+        layout analyze(const std::vector<point>& points, std::vector<uint32_t>& nodes) {
+            layout result;
+            if(points.size() > UINT32_MAX) return result;
+
+            if(points.size() < 3) {
+                result.kind = degeneracy::collinear;
+                if(!points.empty()) result.from = result.to = points[0];
+                if(points.size() == 2) result.to = points[1];
+                return result;
+            }
+
+            // Span the input with its first point and the one farthest from it
+            const point& a = points[0];
+            const point* b = &a;
+            for(const point& p : points) {
+                if(a.distance_squared(p) > a.distance_squared(*b)) b = &p;
+            }
+
+            const point* c = &a;
+            for(const point& p : points) {
+                if(std::fabs(point::orientation(a, *b, p)) > std::fabs(point::orientation(a, *b, *c))) c = &p;
+            }
+
+            result.from = a;
+            result.to = *b;
+
+            if(point::orientation(a, *b, *c) == 0.0) {
+                result.kind = degeneracy::collinear;
+                return result;
+            }
+
+            if(grid(points, result, nodes)) return result;
+
+            if(points.size() > 3) {
+                circle circumcircle = triangle(a, *b, *c).circumcircle();
+
+                bool cocircular = !circumcircle.infinite();
+                for(const point& p : points) {
+                    if(!cocircular) break;
+
+                    double d = p.distance_squared(circumcircle.center);
+                    cocircular = std::fabs(d - circumcircle.radius) <= circle_tolerance * circumcircle.radius;
+                }
+
+                if(cocircular) {
+                    result.kind = degeneracy::cocircular;
+                    result.center = circumcircle.center;
+                }
+            }
+
+            return result;
+        }
+    }
+
+    degeneracy classify(const std::vector<point>& points) {
+        std::vector<uint32_t> nodes;
+        return analyze(points, nodes).kind;
+    }
+
+    bool triangulate_degenerate(const std::vector<point>& points, std::vector<uint32_t>& indices,
+                                std::vector<uint32_t>& hull) {
+        degenerate_buffers scratch;
+        return triangulate_degenerate(points, indices, hull, scratch);
+    }
+
+    bool triangulate_degenerate(const std::vector<point>& points, std::vector<uint32_t>& indices,
+                                std::vector<uint32_t>& hull, degenerate_buffers& scratch) {
+        layout input = analyze(points, scratch.nodes);
+        if(input.kind == degeneracy::general) return false;
+
+        const uint32_t n = static_cast<uint32_t>(points.size());
+
+        indices.clear();
+        hull.clear();
+
+        if(input.kind == degeneracy::collinear) {
+            hull.resize(n);
+            for(uint32_t i = 0; i < n; ++i) hull[i] = i;
+
+            double dx = input.to.x - input.from.x, dy = input.to.y - input.from.y;
+            auto position = [&](uint32_t i) {
+                return (points[i].x - input.from.x) * dx + (points[i].y - input.from.y) * dy;
+            };
+
+            // Ties keep input order, without the buffer of a stable sort
+            std::sort(hull.begin(), hull.end(), [&](uint32_t i, uint32_t j) {
+                double a = position(i), b = position(j);
+                return a < b || (a == b && i < j);
+            });
+
+            // Starting from the smallest end, by x and then y
+            if(dx < 0.0 || (dx == 0.0 && dy < 0.0)) std::reverse(hull.begin(), hull.end());
+        } else if(input.kind == degeneracy::cocircular) {
+            // Around the circle, with repeated points only kept once
+            std::vector<uint32_t>& order = scratch.order;
+            order.resize(n);
+            for(uint32_t i = 0; i < n; ++i) order[i] = i;
+
+            std::vector<double>& angle = scratch.angles;
+            angle.resize(n);
+            for(uint32_t i = 0; i < n; ++i) {
+                angle[i] = std::atan2(points[i].y - input.center.y, points[i].x - input.center.x);
+            }
+
+            std::sort(order.begin(), order.end(), [&](uint32_t i, uint32_t j) {
+                return angle[i] < angle[j] || (angle[i] == angle[j] && i < j);
+            });
+
+            for(uint32_t i : order) {
+                if(!hull.empty() && points[hull.back()].x == points[i].x &&
+                                    points[hull.back()].y == points[i].y) continue;
+                hull.push_back(i);
+            }
+
+            while(hull.size() > 1 && points[hull.back()].x == points[hull[0]].x &&
+                                     points[hull.back()].y == points[hull[0]].y) hull.pop_back();
+
+            indices.reserve(3 * hull.size());
+            for(size_t i = 1; i + 1 < hull.size(); ++i) {
+                if(point::orientation(points[hull[0]], points[hull[i]], points[hull[i + 1]]) <= 0.0) continue;
+                indices.insert(indices.end(), { hull[0], hull[i], hull[i + 1] });
+            }
+        } else {
+            auto node = [&](uint32_t column, uint32_t row) {
+                return scratch.nodes[static_cast<size_t>(row) * input.columns + column];
+            };
+
+            // Split every cell as triangulate_raster does, straight onto the points
+            uint32_t last_column = input.columns - 1, last_row = input.rows - 1;
+            indices.reserve(6 * static_cast<size_t>(last_column) * last_row);
+
+            for(uint32_t row = 0; row < last_row; ++row) {
+                for(uint32_t column = 0; column < last_column; ++column) {
+                    uint32_t v00 = node(column, row), v10 = node(column + 1, row);
+                    uint32_t v01 = node(column, row + 1), v11 = node(column + 1, row + 1);
+
+                    indices.insert(indices.end(), { v00, v10, v11, v00, v11, v01 });
+                }
+            }
+
+            // Boundary nodes, counter-clockwise from the lower-left corner
+            for(uint32_t column = 0; column < last_column; ++column) hull.push_back(node(column, 0));
+            for(uint32_t row = 0; row < last_row; ++row) hull.push_back(node(last_column, row));
+            for(uint32_t column = last_column; column > 0; --column) hull.push_back(node(column, last_row));
+            for(uint32_t row = last_row; row > 0; --row) hull.push_back(node(0, row));
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "geometry.h"
+
+namespace delaunay {
+    enum class degeneracy {
+        // Anything else; needs the general triangulation
+        general,
+
+        // Every point lies on one line (including fewer than 3 points)
+        collinear,
+
+        // Every point lies on one circle, so any triangulation is Delaunay
+        cocircular,
+
+        // Axis-aligned regular grid, every node present exactly once
+        grid
+    };
+
+    // Recognize degenerate inputs in O(n)
+    degeneracy classify(const std::vector<point>& points);
+
+    /*
+    ** Triangulate a degenerate input directly, into counter-clockwise index
+    ** triples and a counter-clockwise hull ring, and return true; return false
+    ** for general inputs. Collinear points have no triangles and their hull
+    ** is the points ordered along the line, from its smallest end. Cocircular points are fanned out
+    ** from one of them. Every grid cell is split along the same diagonal,
+    ** from its lower-left to its upper-right corner.
+     */
+    bool triangulate_degenerate(const std::vector<point>& points, std::vector<uint32_t>& indices,
+                                std::vector<uint32_t>& hull);
+
+    // Working space of triangulate_degenerate, kept between calls so that
+    // once it has grown, triangulating again allocates nothing
+    class degenerate_buffers {
+    public:
+        std::vector<uint32_t> nodes, order;
+        std::vector<double> angles;
+    };
+
+    bool triangulate_degenerate(const std::vector<point>& points, std::vector<uint32_t>& indices,
+                                std::vector<uint32_t>& hull, degenerate_buffers& scratch);
+}
@@ -1,7 +1,11 @@
 #include <limits>
 #include <algorithm>
+#include <chrono>
+#include <stdexcept>
 
-#include "geometry.h"
+#include "delaunay.h"
+#include "engine.h"
+#include "trace.h"
 
 namespace delaunay {
     triangle super_triangle() {
@@ -21,6 +25,33 @@ namespace delaunay {
         return triangle(point(-inf, -inf), point(0, inf), point(inf, 0));
     }
 
+    namespace {
+        // Whether p is inside the circle through the finite vertices v1, v2
+        // and the infinite vertex f of the super triangle
+        bool edge_circle_contains(const point& f, const point& v1, const point& v2, const point& p) {
+            /* The line from v1 to v2 will be tangent to the circle, and the
+            ** interior is the side facing the infinite vertex. Symbolically the
+            ** super triangle is (-M, -M), (0, 2M), (2M, 0) for M -> inf, so
+            ** that side is given by the direction of f, or by the offset of
+            ** the line when it runs parallel to that direction.
+            **
+            ** Orientations are used rather than the slope of the line, which
+            ** loses all precision as the line approaches vertical.
+             */
+            double inf = std::numeric_limits<double>::infinity();
+            double dx = v2.x - v1.x;
+            double dy = v2.y - v1.y;
+
+            point d = f.y == inf ? point(0, 2) : f.x == inf ? point(2, 0) : point(-1, -1);
+
+            double facing = dx * d.y - dy * d.x;
+            if(facing == 0.0) facing = dy * v1.x - dx * v1.y;
+
+            double side = dx * (p.y - v1.y) - dy * (p.x - v1.x);
+            return (facing > 0.0 && side > 0.0) || (facing < 0.0 && side < 0.0);
+        }
+    }
+
     bool halfplane_contains(const triangle& t, const point& p) {
         /* If t circumscribes a circle with infinite radius, this circle is
         ** a line locally. We just need to find out which side of the half-plane
@@ -68,9 +99,9 @@ namespace delaunay {
                 }
             } else {
                 // Vertices: { (-inf, -inf), (inf, 0) }
-                // y = 1/3x + b
-                double b = f.y - f.x / 3.0;
-                if(p.y - p.x / 3.0 < b) return true;
+                // y = 1/3x + b, scaled by 3 so integers compare exactly
+                double b = 3.0 * f.y - f.x;
+                if(3.0 * p.y - p.x < b) return true;
             }
         } else if(finite_points == 2) {
             point f, v1, v2;
@@ -82,103 +113,232 @@ namespace delaunay {
                 f = t.c; v1 = t.b; v2 = t.a;
             }
 
-            // The line from v1 to v2 will be tangent to the circle
-            double m = point::slope(v1, v2);
-            double b = v1.y - m * v1.x;
-            if(f.y == inf) {
-                // Vertex: (0, inf)
-                // The circle interior is always above the line
-                if(p.y - m * p.x > b) return true;
-            } else if(f.x == inf) {
-                // Vertex: (inf, 0)
-                if(m >= 0.0) {
-                    if(p.y - m * p.x < b) return true;
-                } else if(p.y - m * p.x > b) return true;
-            } else {
-                // Vertex: (-inf, -inf)
-                if(m >= 1.0) {
-                    if(p.y - m * p.x > b) return true;
-                } else if(p.y - m * p.x < b) return true;
-            }
+            return edge_circle_contains(f, v1, v2, p);
         }
 
         return false;
     }
 
     std::vector<triangle> triangulate(const std::vector<point>& points) {
-        /*
-        ** Bowyer-Watson algorithm
-        ** Reference: https://en.wikipedia.org/wiki/Bowyer-Watson_algorithm
-         */
+        return triangulate(points, nullptr);
+    }
+
+    std::vector<triangle> triangulate(const std::vector<point>& points, statistics& stats) {
+        stats = statistics();
+        return triangulate(points, &stats);
+    }
+
+    std::vector<triangle> triangulate(const std::vector<point>& points, statistics* stats) {
+        std::vector<uint32_t> indices, hull;
+        triangulate(points, indices, hull, stats);
+
+        trace_span span("output");
+
         std::vector<triangle> triangulation;
+        triangulation.reserve(indices.size() / 3);
 
-        triangle super = super_triangle();
-        triangulation.push_back(super);
+        for(size_t i = 0; i < indices.size(); i += 3) {
+            triangulation.emplace_back(points[indices[i]], points[indices[i + 1]], points[indices[i + 2]]);
+        }
 
-        // Add each point to the triangulation
-        for(const point& p : points) {
-            std::vector<triangle> bad_set;
+        return triangulation;
+    }
 
-            // Find out which triangles are invalidated when adding this point
-            for(const triangle& t : triangulation) {
-                circle circumcircle = t.circumcircle();
-                if(!circumcircle.infinite()) {
-                    if(circumcircle.contains(p)) bad_set.push_back(t);
-                } else {
-                    if(halfplane_contains(t, p)) bad_set.push_back(t);
-                }
+    void triangulate(const std::vector<point>& points, std::vector<uint32_t>& indices,
+                     std::vector<uint32_t>& hull, statistics* stats) {
+        triangulate_with<circle_kernel>(points, indices, hull, stats);
+    }
+
+    namespace {
+        // Triangulate with the engine (see engine.h), then drop the ghosts
+        // and collect the hull
+        template<typename kernel, bool weighted>
+        void bowyer_watson(const std::vector<point>& points, const std::vector<double>& weights,
+                           engine::buffers<kernel>& scratch, std::vector<uint32_t>& indices,
+                           std::vector<uint32_t>& hull, [[maybe_unused]] statistics* stats) {
+            using clock = std::chrono::steady_clock;
+            using cell = engine::cell<kernel>;
+
+            // Points per traced insertion span
+            const size_t batch = 1024;
+
+            trace_span span("triangulate");
+
+            const uint32_t n = static_cast<uint32_t>(points.size());
+
+            engine::triangulation<kernel, weighted> triangulation(scratch, points, weights, n, stats);
+            triangulation.reset();
+
+            std::vector<cell>& cells = scratch.cells;
+
+            [[maybe_unused]] clock::time_point start = clock::now();
+
+            for(uint32_t i = 0; i < n; i += batch) {
+                trace_span batch_span("insert", i / batch);
+
+                uint32_t last = static_cast<uint32_t>(std::min<size_t>(n, size_t(i) + batch));
+                for(uint32_t p = i; p < last; ++p) triangulation.insert(p);
             }
 
-            std::vector<edge> polygon;
+            STATISTIC(stats->insert_time = std::chrono::duration<double>(clock::now() - start).count());
+            start = clock::now();
 
-            // Find edges not shared with any other flagged triangles
-            for(size_t i = 0; i < bad_set.size(); ++i) {
-                std::vector<edge> edges = bad_set[i].edges();
+            trace_span cleanup_span("cleanup");
 
-                for(const edge& e : edges) {
-                    bool shared_edge = false;
-                    for(size_t j = 0; j < bad_set.size(); ++j) {
-                        if(i == j) continue;
+            /* Triangles with exactly one ghost vertex line the convex hull: in the
+            ** counter-clockwise (a, b, ghost), the hull runs from b to a. Their
+            ** edges are chained into the hull ring before the ghosts are dropped.
+            ** Without any real triangle the input is degenerate and has no hull.
+             */
+            std::vector<uint32_t>& next = scratch.next;
+            next.assign(n, engine::dead);
+            uint32_t first = engine::dead;
+            bool any_real = false;
 
-                        if(bad_set[j].has_edge(e)) {
-                            shared_edge = true;
-                            break;
-                        }
-                    }
+            for(const cell& c : cells) {
+                uint32_t ghost_count = (c.v[0] >= n) + (c.v[1] >= n) + (c.v[2] >= n);
+                any_real |= ghost_count == 0;
 
-                    if(!shared_edge) polygon.push_back(e);
-                }
+                if(ghost_count != 1) continue;
+
+                int g = c.v[0] >= n ? 0 : c.v[1] >= n ? 1 : 2;
+                uint32_t a = c.v[(g + 1) % 3], b = c.v[(g + 2) % 3];
+
+                next[b] = a;
+                first = b;
+            }
+
+            hull.clear();
+            if(any_real && first != engine::dead) {
+                uint32_t v = first;
+                do {
+                    hull.push_back(v);
+                    v = next[v];
+                } while(v != first && v != engine::dead && hull.size() <= n);
+            }
+
+            indices.clear();
+            indices.reserve(cells.size() * 3);
+
+            for(const cell& c : cells) {
+                if(std::max({ c.v[0], c.v[1], c.v[2] }) >= n) continue;
+
+                indices.insert(indices.end(), c.v, c.v + 3);
             }
 
-            // Remove all bad triangles from the triangulation
-            auto predicate = [&](triangle t) {
-                return std::find(bad_set.begin(), bad_set.end(), t) != bad_set.end();
-            };
+            STATISTIC(stats->triangles_destroyed += cells.size() - indices.size() / 3);
+            STATISTIC(stats->cleanup_time = std::chrono::duration<double>(clock::now() - start).count());
+        }
+    }
+
+    void triangulate_regular(const std::vector<point>& points, const std::vector<double>& weights,
+                             std::vector<uint32_t>& indices, std::vector<uint32_t>& hull, statistics* stats) {
+        if(points.size() > UINT32_MAX - 3) throw std::length_error("too many points");
+        if(!weights.empty() && weights.size() != points.size()) {
+            throw std::invalid_argument("expected one weight per point");
+        }
+
+        engine::buffers<circle_kernel> scratch;
+        if(weights.empty()) {
+            bowyer_watson<circle_kernel, false>(points, weights, scratch, indices, hull, stats);
+        } else {
+            bowyer_watson<circle_kernel, true>(points, weights, scratch, indices, hull, stats);
+        }
+    }
 
-            triangulation.erase(std::remove_if(triangulation.begin(),
-                                               triangulation.end(),
-                                               predicate), triangulation.end());
+    namespace {
+        template<typename kernel>
+        void triangulate_into(const std::vector<point>& points, engine::buffers<kernel>& scratch,
+                              std::vector<uint32_t>& indices, std::vector<uint32_t>& hull,
+                              [[maybe_unused]] statistics* stats) {
+            if(points.size() > UINT32_MAX - 3) throw std::length_error("too many points");
 
-            // Connect edges to our point to form a new triangle
-            for(size_t j = 0; j < polygon.size(); ++j) {
-                edge e = polygon[j];
+            for(const point& p : points) {
+                if(!kernel::accepts(p)) throw std::invalid_argument("point outside the kernel's bounds");
+            }
 
-                triangulation.emplace_back(e.a, e.b, p);
+            // Lines, circles and grids need no search at all, but their
+            // shortcut picks diagonals of its own
+            if(!kernel::perturbed && triangulate_degenerate(points, indices, hull, scratch.degenerate)) {
+                STATISTIC(stats->points += points.size());
+                STATISTIC(stats->triangles_created += indices.size() / 3);
+                return;
             }
+
+            bowyer_watson<kernel, false>(points, {}, scratch, indices, hull, stats);
         }
+    }
 
-        // Remove any remaining triangle connected to the super triangle
-        auto predicate = [&](triangle t) {
-            return
-                t.has_vertex(super.a) ||
-                t.has_vertex(super.b) ||
-                t.has_vertex(super.c);
-        };
+    template<typename kernel>
+    void triangulate_with(const std::vector<point>& points, std::vector<uint32_t>& indices,
+                          std::vector<uint32_t>& hull, statistics* stats) {
+        engine::buffers<kernel> scratch;
+        triangulate_into(points, scratch, indices, hull, stats);
+    }
 
-        triangulation.erase(
-            std::remove_if(triangulation.begin(), triangulation.end(),
-                           predicate), triangulation.end());
+    template void triangulate_with<circle_kernel>(const std::vector<point>&, std::vector<uint32_t>&,
+                                                  std::vector<uint32_t>&, statistics*);
+    template void triangulate_with<grid_kernel>(const std::vector<point>&, std::vector<uint32_t>&,
+                                                std::vector<uint32_t>&, statistics*);
+    template void triangulate_with<exact_kernel>(const std::vector<point>&, std::vector<uint32_t>&,
+                                                 std::vector<uint32_t>&, statistics*);
 
-        return triangulation;
+    mesh triangulate_regular(const std::vector<point>& points, const std::vector<double>& weights,
+                             std::vector<uint32_t>* hidden, statistics* stats) {
+        mesh m;
+        m.vertices = points;
+
+        triangulate_regular(points, weights, m.indices, m.hull, stats);
+
+        trace_span span("index");
+
+        m.constraints.assign(m.size(), 0);
+        m.connect();
+
+        if(hidden) {
+            std::vector<uint8_t> used(points.size(), 0);
+            for(uint32_t v : m.indices) used[v] = 1;
+
+            hidden->clear();
+            for(uint32_t v = 0; v < used.size(); ++v) {
+                if(!used[v]) hidden->push_back(v);
+            }
+        }
+
+        return m;
+    }
+
+    mesh triangulate_mesh(const std::vector<point>& points, statistics* stats) {
+        mesh m;
+        m.vertices = points;
+
+        triangulate(points, m.indices, m.hull, stats);
+
+        trace_span span("index");
+
+        m.constraints.assign(m.size(), 0);
+        m.connect();
+
+        return m;
+    }
+
+    class triangulator::workspace: public engine::buffers<circle_kernel> {};
+
+    triangulator::triangulator(): scratch(new workspace()) {}
+    triangulator::triangulator(triangulator&& other) = default;
+    triangulator& triangulator::operator=(triangulator&& other) = default;
+    triangulator::~triangulator() {}
+
+    const std::vector<triangle>& triangulator::triangulate(const std::vector<point>& points, statistics* stats) {
+        triangulate_into(points, *scratch, indices, hull, stats);
+
+        trace_span span("output");
+
+        triangles.clear();
+        for(size_t i = 0; i < indices.size(); i += 3) {
+            triangles.emplace_back(points[indices[i]], points[indices[i + 1]], points[indices[i + 2]]);
+        }
+
+        return triangles;
     }
 }
@@ -1,6 +1,86 @@
 #pragma once
+#include <memory>
+
 #include "geometry.h"
+#include "kernel.h"
+#include "mesh.h"
+#include "statistics.h"
 
 namespace delaunay {
+    // Triangle with symbolic vertices at infinity enclosing every point
+    triangle super_triangle();
+
+    // Whether p lies inside the (half-plane) circumcircle of a triangle
+    // with vertices at infinity
+    bool halfplane_contains(const triangle& t, const point& p);
+
     std::vector<triangle> triangulate(const std::vector<point>& points);
+
+    // Triangulate and report what the run cost (see statistics.h)
+    std::vector<triangle> triangulate(const std::vector<point>& points, statistics& stats);
+    std::vector<triangle> triangulate(const std::vector<point>& points, statistics* stats);
+
+    // Triangulate into counter-clockwise index triples and the convex hull
+    // as a counter-clockwise ring of vertex indices
+    void triangulate(const std::vector<point>& points, std::vector<uint32_t>& indices,
+                     std::vector<uint32_t>& hull, statistics* stats = nullptr);
+
+    /*
+    ** Triangulate with the in-circle kernel fixed at compile time (see
+    ** kernel.h); triangulate() uses circle_kernel. Throws
+    ** std::invalid_argument when a point is outside the kernel's bounds.
+    ** Built for circle_kernel, grid_kernel and exact_kernel.
+     */
+    template<typename kernel>
+    void triangulate_with(const std::vector<point>& points, std::vector<uint32_t>& indices,
+                          std::vector<uint32_t>& hull, statistics* stats = nullptr);
+
+    extern template void triangulate_with<circle_kernel>(const std::vector<point>&, std::vector<uint32_t>&,
+                                                         std::vector<uint32_t>&, statistics*);
+    extern template void triangulate_with<grid_kernel>(const std::vector<point>&, std::vector<uint32_t>&,
+                                                       std::vector<uint32_t>&, statistics*);
+    extern template void triangulate_with<exact_kernel>(const std::vector<point>&, std::vector<uint32_t>&,
+                                                        std::vector<uint32_t>&, statistics*);
+
+    // Triangulate and index the result against the input points
+    mesh triangulate_mesh(const std::vector<point>& points, statistics* stats = nullptr);
+
+    /*
+    ** Context for triangulating many small inputs, e.g. one per request. It
+    ** keeps the engine's working buffers and its results from call to call,
+    ** so once they have grown to fit the largest input seen, triangulating
+    ** allocates nothing. Use one triangulator per thread.
+     */
+    class triangulator {
+    public:
+        // The last triangulation as triangles, and as counter-clockwise index
+        // triples and hull ring
+        std::vector<triangle> triangles;
+        std::vector<uint32_t> indices, hull;
+
+        triangulator();
+        triangulator(triangulator&& other);
+        triangulator& operator=(triangulator&& other);
+        ~triangulator();
+
+        // Replace the last triangulation with that of points
+        const std::vector<triangle>& triangulate(const std::vector<point>& points, statistics* stats = nullptr);
+
+    private:
+        class workspace;
+        std::unique_ptr<workspace> scratch;
+    };
+
+    /*
+    ** Regular (weighted Delaunay) triangulation, the dual of the power
+    ** diagram. Each point carries a weight, its squared radius as a circle;
+    ** empty weights give the Delaunay triangulation. Points whose power cell
+    ** is empty are hidden: they are not referenced by any triangle, and are
+    ** listed in `hidden` when given.
+     */
+    void triangulate_regular(const std::vector<point>& points, const std::vector<double>& weights,
+                             std::vector<uint32_t>& indices, std::vector<uint32_t>& hull,
+                             statistics* stats = nullptr);
+    mesh triangulate_regular(const std::vector<point>& points, const std::vector<double>& weights,
+                             std::vector<uint32_t>* hidden = nullptr, statistics* stats = nullptr);
 }
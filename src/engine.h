@@ -0,0 +1,215 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "degenerate.h"
+#include "delaunay.h"
+#include "kernel.h"
+#include "statistics.h"
+
+#ifdef DELAUNAY_STATISTICS
+#define STATISTIC(expression) do { if(stats) { expression; } } while(0)
+#else
+#define STATISTIC(expression) do {} while(0)
+#endif
+
+namespace delaunay {
+    /*
+    ** The indexed Bowyer-Watson engine, shared by triangulate() and the
+    ** streaming triangulator. Internal: not part of the library interface.
+     */
+    namespace engine {
+        /* Triangle of the indexed engine, counter-clockwise. Indices n, n + 1
+        ** and n + 2 (for n input points) are the symbolic vertices of the
+        ** super triangle, so telling them apart is a single integer compare.
+        ** The kernel's circumcircle (the power circle, with weights) is
+        ** computed once, when the triangle is created.
+         */
+        template<typename kernel>
+        class cell {
+        public:
+            uint32_t v[3];
+            typename kernel::circumcircle circumcircle;
+
+            cell(uint32_t a, uint32_t b, uint32_t c, const typename kernel::circumcircle& circumcircle):
+                v{a, b, c}, circumcircle(circumcircle) {}
+        };
+
+        class directed_edge {
+        public:
+            uint32_t a, b;
+        };
+
+        // Working storage of the engine, kept by a triangulator between calls
+        template<typename kernel>
+        class buffers {
+        public:
+            std::vector<cell<kernel>> cells;
+            std::vector<uint32_t> bad, next;
+            std::vector<directed_edge> edges, polygon;
+            degenerate_buffers degenerate;
+        };
+
+        const uint32_t dead = UINT32_MAX;
+
+        template<typename T>
+        void push(std::vector<T>& list, const T& value, [[maybe_unused]] statistics* stats) {
+            STATISTIC(stats->allocations += list.size() == list.capacity());
+            list.push_back(value);
+        }
+
+        /*
+        ** Bowyer-Watson algorithm
+        ** Reference: https://en.wikipedia.org/wiki/Bowyer-Watson_algorithm
+        **
+        ** The cells of a triangulation in progress, over the vertices below n
+        ** and the ghosts n, n + 1 and n + 2. insert() adds one vertex.
+        **
+        ** With weights, the circumcircle becomes the power circle and a point
+        ** conflicts with a triangle when its power with respect to that circle
+        ** is below its weight: its lifted point lies below the triangle's
+        ** plane. A point that conflicts with nothing is hidden, and points
+        ** left inside a cavity are hidden by the new one.
+         */
+        template<typename kernel, bool weighted = false>
+        class triangulation {
+        public:
+            static_assert(!weighted || std::is_same<kernel, circle_kernel>::value,
+                          "power circles are kept in double precision");
+
+            buffers<kernel>& scratch;
+            const std::vector<point>& points;
+            const std::vector<double>& weights;
+            const uint32_t n;
+            statistics* stats;
+
+            // The super triangle, reordered to be counter-clockwise
+            point ghosts[3];
+
+            triangulation(buffers<kernel>& scratch, const std::vector<point>& points,
+                          const std::vector<double>& weights, uint32_t n, statistics* stats):
+                scratch(scratch), points(points), weights(weights), n(n), stats(stats) {
+                triangle super = super_triangle();
+                ghosts[0] = super.a;
+                ghosts[1] = super.c;
+                ghosts[2] = super.b;
+            }
+
+            const point& vertex(uint32_t v) const {
+                return v < n ? points[v] : ghosts[v - n];
+            }
+
+            cell<kernel> make_cell(uint32_t a, uint32_t b, uint32_t c) const {
+                if constexpr(weighted) {
+                    triangle t(vertex(a), vertex(b), vertex(c));
+                    if(std::max({ a, b, c }) >= n) return cell<kernel>(a, b, c, t.circumcircle());
+
+                    return cell<kernel>(a, b, c, t.power_circle(weights[a], weights[b], weights[c]));
+                } else {
+                    return cell<kernel>(a, b, c, kernel::make(vertex(a), vertex(b), vertex(c)));
+                }
+            }
+
+            // Start over from the super triangle alone
+            void reset() {
+                scratch.cells.clear();
+                push(scratch.cells, make_cell(n, n + 1, n + 2), stats);
+                STATISTIC(stats->triangles_created++);
+            }
+
+            void insert(uint32_t p) {
+                std::vector<cell<kernel>>& cells = scratch.cells;
+                std::vector<uint32_t>& bad = scratch.bad;
+                std::vector<directed_edge>& edges = scratch.edges;
+                std::vector<directed_edge>& polygon = scratch.polygon;
+
+                const point& q = points[p];
+
+                // Find out which triangles are invalidated when adding this point
+                bad.clear();
+                for(uint32_t t = 0; t < cells.size(); ++t) {
+                    const cell<kernel>& c = cells[t];
+
+                    bool invalid;
+                    if(kernel::finite(c.circumcircle)) {
+                        STATISTIC(stats->incircle_tests++);
+                        if constexpr(weighted) {
+                            invalid = c.circumcircle.power(q) < weights[p];
+                        } else {
+                            invalid = kernel::conflicts(c.circumcircle, q);
+                        }
+                    } else {
+                        STATISTIC(stats->halfplane_tests++);
+
+                        // A hull edge is the one between the real vertices,
+                        // with the ghost to its left
+                        uint32_t ghost_count = (c.v[0] >= n) + (c.v[1] >= n) + (c.v[2] >= n);
+                        if(ghost_count == 1) {
+                            int g = c.v[0] >= n ? 0 : c.v[1] >= n ? 1 : 2;
+                            const point& a = vertex(c.v[(g + 1) % 3]);
+                            const point& b = vertex(c.v[(g + 2) % 3]);
+
+                            invalid = kernel::beyond(a, b, q) || kernel::on_edge(a, b, q);
+                        } else if(ghost_count == 2) {
+                            /* The circle through a point and two ghosts is the
+                            ** half-plane beyond the line through the point,
+                            ** parallel to the ghosts' edge of the symbolic
+                            ** super triangle (-M, -M), (2M, 0), (0, 2M) (see
+                            ** halfplane_contains), which the missing ghost names.
+                             */
+                            static const point directions[3] = { point(1, -1), point(1, 3), point(-3, -1) };
+
+                            int f = c.v[0] < n ? 0 : c.v[1] < n ? 1 : 2;
+                            uint32_t missing = 3 * n + 3 - c.v[(f + 1) % 3] - c.v[(f + 2) % 3];
+
+                            invalid = kernel::ahead(vertex(c.v[f]), directions[missing - n], q);
+                        } else {
+                            invalid = ghost_count == 3;
+                        }
+                    }
+
+                    if(invalid) push(bad, t, stats);
+                }
+
+                STATISTIC(stats->points++);
+                STATISTIC(stats->cavity(bad.size()));
+
+                // Edges of the cavity are the ones whose twin is not in the cavity
+                edges.clear();
+                for(uint32_t t : bad) {
+                    const uint32_t* v = cells[t].v;
+                    for(int k = 0; k < 3; ++k) push(edges, directed_edge{ v[k], v[(k + 1) % 3] }, stats);
+                }
+
+                polygon.clear();
+                for(const directed_edge& e : edges) {
+                    bool shared_edge = false;
+                    for(const directed_edge& f : edges) {
+                        STATISTIC(stats->boundary_comparisons++);
+                        if(f.a == e.b && f.b == e.a) {
+                            shared_edge = true;
+                            break;
+                        }
+                    }
+
+                    if(!shared_edge) push(polygon, e, stats);
+                }
+
+                // Remove all bad triangles from the triangulation
+                for(uint32_t t : bad) cells[t].v[0] = dead;
+
+                cells.erase(std::remove_if(cells.begin(), cells.end(), [](const cell<kernel>& c) {
+                    return c.v[0] == dead;
+                }), cells.end());
+
+                STATISTIC(stats->triangles_destroyed += bad.size());
+                STATISTIC(stats->triangles_created += polygon.size());
+
+                // Connect edges to our point to form new (counter-clockwise) triangles
+                for(const directed_edge& e : polygon) push(cells, make_cell(e.a, e.b, p), stats);
+            }
+        };
+    }
+}
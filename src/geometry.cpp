@@ -26,6 +26,10 @@ point point::midpoint(const point& a, const point& b) {
     return point((a.x + b.x) / 2.0, (a.y + b.y) / 2.0);
 }
 
+double point::orientation(const point& a, const point& b, const point& c) {
+    return (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
+}
+
 double point::distance_squared(const point& a) const {
     double dx = x - a.x;
     double dy = y - a.y;
@@ -45,6 +49,13 @@ bool circle::contains(const point& p) const {
     return dist < radius;
 }
 
+double circle::power(const point& p) const {
+    double dx = (p.x - center.x);
+    double dy = (p.y - center.y);
+
+    return dx * dx + dy * dy - radius;
+}
+
 bool circle::infinite() const {
     return radius == std::numeric_limits<double>::infinity();
 }
@@ -65,7 +76,7 @@ bool triangle::valid() const {
 
     // | b.x - a.x  c.x - a.x |
     // | b.y - a.y  c.y - a.y |
-    double area = ((b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y)) / 2.0;
+    double area = point::orientation(a, b, c) / 2.0;
 
     // Check the actual area, not signed area
     return fabs(area) > std::numeric_limits<double>::epsilon();
@@ -141,6 +152,32 @@ circle triangle::circumcircle() const {
     return circle(center, radius);
 }
 
+circle triangle::power_circle(double weight_a, double weight_b, double weight_c) const {
+    if(!valid()) {
+        return circle(point(0, 0), std::numeric_limits<double>::infinity());
+    }
+
+    /*
+    ** The center o satisfies |p - o|^2 - w_p = r^2 for every vertex p.
+    ** Subtracting the equation of a removes r^2 and leaves two linear
+    ** equations, solved relative to a to keep the coordinates small:
+    **   2 (b - a) . (o - a) = |b - a|^2 - (w_b - w_a)
+    **   2 (c - a) . (o - a) = |c - a|^2 - (w_c - w_a)
+     */
+    double bx = b.x - a.x, by = b.y - a.y;
+    double cx = c.x - a.x, cy = c.y - a.y;
+
+    double rhs_b = bx * bx + by * by - (weight_b - weight_a);
+    double rhs_c = cx * cx + cy * cy - (weight_c - weight_a);
+
+    double det = 2.0 * (bx * cy - by * cx);
+
+    double x = (rhs_b * cy - rhs_c * by) / det;
+    double y = (bx * rhs_c - cx * rhs_b) / det;
+
+    return circle(point(a.x + x, a.y + y), x * x + y * y - weight_a);
+}
+
 bool triangle::has_edge(edge e) const {
     std::vector<edge> list = edges();
     for(const edge& v : list) {
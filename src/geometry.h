@@ -15,6 +15,9 @@ public:
 
     static double slope(const point& a, const point& b);
     static point midpoint(const point& a, const point& b);
+
+    // Twice the signed area of (a, b, c), positive counter-clockwise
+    static double orientation(const point& a, const point& b, const point& c);
 };
 
 
@@ -32,6 +35,12 @@ public:
     circle(point center, double radius);
 
     bool contains(const point& p) const;
+
+    // Power of p with respect to the circle, negative inside. The radius is
+    // stored squared; for the orthogonal circle of weighted points it may be
+    // negative.
+    double power(const point& p) const;
+
     bool infinite() const;
 };
 
@@ -47,6 +56,11 @@ public:
 
     circle circumcircle() const;
 
+    // Circle orthogonal to the vertices taken as weighted points (circles of
+    // squared radius weight): every vertex has power equal to its weight.
+    // Infinite when the vertices are collinear.
+    circle power_circle(double weight_a, double weight_b, double weight_c) const;
+
     bool has_edge(edge e) const;
 
     std::vector<edge> edges() const;
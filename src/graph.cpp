@@ -0,0 +1,198 @@
+#include "graph.h"
+
+#include <numeric>
+
+#include "parallel.h"
+#include "trace.h"
+
+namespace delaunay {
+    namespace {
+        // Call visit(slot, neighbor) for every edge of the mesh once
+        template<typename visitor>
+        void each_edge(const mesh_view& m, visitor visit) {
+            for(uint32_t slot = 0; slot < 3 * m.size(); ++slot) {
+                uint32_t u = m.neighbors[slot];
+                if(u == mesh::none || u < slot / 3) visit(slot, u);
+            }
+        }
+
+        uint32_t head(const mesh_view& m, uint32_t slot) {
+            return m.indices[mesh::next(slot)];
+        }
+
+        uint32_t opposite(const mesh_view& m, uint32_t slot) {
+            return m.indices[mesh::previous(slot)];
+        }
+
+        class weighted_edge {
+        public:
+            double length;
+            uint32_t a, b;
+        };
+    }
+
+    std::vector<uint32_t> unique_edges(const mesh_view& m) {
+        trace_span span("unique edges");
+
+        // Three edges per triangle, each shared by two but on the hull
+        std::vector<uint32_t> edges;
+        edges.reserve(3 * m.size() + m.hull_count);
+
+        each_edge(m, [&](uint32_t slot, uint32_t) {
+            edges.push_back(m.indices[slot]);
+            edges.push_back(head(m, slot));
+        });
+
+        return edges;
+    }
+
+    std::vector<uint32_t> gabriel_graph(const mesh_view& m) {
+        trace_span span("gabriel graph");
+
+        std::vector<uint32_t> edges;
+
+        /* An edge of a Delaunay triangulation is Gabriel exactly when neither
+        ** opposite vertex lies inside its diametral circle: any other vertex
+        ** inside it would put one of them inside too.
+         */
+        each_edge(m, [&](uint32_t slot, uint32_t u) {
+            uint32_t a = m.indices[slot], b = head(m, slot);
+
+            point middle = point::midpoint(m.vertices[a], m.vertices[b]);
+            double half = m.vertices[a].distance_squared(m.vertices[b]) / 4.0;
+
+            bool empty = m.vertices[opposite(m, slot)].distance_squared(middle) >= half;
+            if(u != mesh::none) {
+                for(uint32_t i = 0; i < 3; ++i) {
+                    if(m.indices[3 * u + i] == b) empty &= m.vertices[opposite(m, 3 * u + i)].distance_squared(middle) >= half;
+                }
+            }
+
+            if(!empty) return;
+
+            edges.push_back(a);
+            edges.push_back(b);
+        });
+
+        return edges;
+    }
+
+    size_t adjacency::size() const {
+        return offsets.empty() ? 0 : offsets.size() - 1;
+    }
+
+    size_t adjacency::degree(size_t v) const {
+        return offsets[v + 1] - offsets[v];
+    }
+
+    adjacency vertex_adjacency(const mesh_view& m, unsigned threads) {
+        trace_span span("vertex adjacency");
+
+        // Vertices per unit of parallel work
+        const size_t chunk = 1 << 14;
+
+        const size_t count = m.vertex_count;
+        const uint32_t slot_count = static_cast<uint32_t>(3 * m.size());
+
+        /* A vertex has one neighbor per triangle around it, and one more for
+        ** every fan of triangles that ends on the boundary, where the edge
+        ** leaving it has no neighbor. Most vertices have a single fan, but
+        ** where a mask or constraint pinches the mesh, several meet at one
+        ** vertex.
+         */
+        adjacency graph;
+        graph.offsets.assign(count + 1, 0);
+
+        std::vector<uint32_t> first(count + 1, 0);
+        for(uint32_t slot = 0; slot < slot_count; ++slot) {
+            graph.offsets[m.indices[slot] + 1] += 1 + (m.neighbors[slot] == mesh::none);
+            first[m.indices[slot] + 1]++;
+        }
+
+        std::partial_sum(graph.offsets.begin(), graph.offsets.end(), graph.offsets.begin());
+        graph.neighbors.resize(graph.offsets.back());
+
+        // Every slot of vertex v is in slots[first[v]] up to slots[first[v + 1]]
+        std::partial_sum(first.begin(), first.end(), first.begin());
+
+        std::vector<uint32_t> slots(slot_count);
+        std::vector<uint32_t> fill(first.begin(), first.end() - 1);
+        for(uint32_t slot = 0; slot < slot_count; ++slot) slots[fill[m.indices[slot]]++] = slot;
+
+        // Each slot belongs to one vertex, so threads never share an entry
+        std::vector<uint8_t> visited(slot_count, 0);
+
+        parallel_for((count + chunk - 1) / chunk, threads, [&](size_t part) {
+            for(size_t v = part * chunk; v < std::min(count, (part + 1) * chunk); ++v) {
+                uint32_t* out = &graph.neighbors[graph.offsets[v]];
+
+                // Fans ending on the boundary from their most clockwise
+                // triangle first, then a closed fan from any triangle
+                for(int pass = 0; pass < 2; ++pass) {
+                    for(uint32_t k = first[v]; k < first[v + 1]; ++k) {
+                        uint32_t slot = slots[k], last = slot;
+                        if(visited[slot] || (pass == 0 && m.neighbors[slot] != mesh::none)) continue;
+
+                        // Each triangle adds the head of the edge leaving v
+                        while(slot != mesh::none && !visited[slot]) {
+                            visited[slot] = 1;
+                            *out++ = head(m, slot);
+                            last = slot;
+
+                            slot = m.next_around(slot);
+                        }
+
+                        // Past the last triangle of an open fan, the boundary edge arriving at v
+                        if(slot == mesh::none) *out++ = opposite(m, last);
+                    }
+                }
+            }
+        });
+
+        return graph;
+    }
+
+    std::vector<uint32_t> minimum_spanning_tree(const mesh_view& m, unsigned threads) {
+        trace_span span("minimum spanning tree");
+
+        std::vector<weighted_edge> edges;
+        edges.reserve((3 * m.size() + m.hull_count) / 2);
+
+        each_edge(m, [&](uint32_t slot, uint32_t) {
+            uint32_t a = m.indices[slot], b = head(m, slot);
+            edges.push_back(weighted_edge{ m.vertices[a].distance_squared(m.vertices[b]), a, b });
+        });
+
+        parallel_sort(edges.begin(), edges.end(), [](const weighted_edge& a, const weighted_edge& b) {
+            return a.length < b.length;
+        }, threads);
+
+        // Union-find with path halving and union by size
+        std::vector<uint32_t> parent(m.vertex_count), size(m.vertex_count, 1);
+        std::iota(parent.begin(), parent.end(), 0);
+
+        auto find = [&](uint32_t v) {
+            while(parent[v] != v) v = parent[v] = parent[parent[v]];
+            return v;
+        };
+
+        std::vector<uint32_t> tree;
+        tree.reserve(m.vertex_count ? 2 * (m.vertex_count - 1) : 0);
+
+        for(const weighted_edge& e : edges) {
+            uint32_t a = find(e.a), b = find(e.b);
+            if(a == b) continue;
+
+            if(size[a] < size[b]) std::swap(a, b);
+            parent[b] = a;
+            size[a] += size[b];
+
+            tree.push_back(e.a);
+            tree.push_back(e.b);
+
+            if(tree.size() == 2 * (m.vertex_count - 1)) break;
+        }
+
+        return tree;
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "mesh.h"
+
+namespace delaunay {
+    /*
+    ** Proximity graphs read off a Delaunay mesh. Every graph is a list of
+    ** edges, two vertex indices per edge. The Delaunay edges contain the
+    ** Gabriel graph, which in turn contains the Euclidean minimum spanning
+    ** tree.
+     */
+
+    // Every edge of the mesh once, found through the neighbor table: an
+    // interior edge is taken from the triangle with the larger index
+    std::vector<uint32_t> unique_edges(const mesh_view& m);
+
+    // Edges whose diametral circle holds no other vertex
+    std::vector<uint32_t> gabriel_graph(const mesh_view& m);
+
+    // Euclidean minimum spanning tree (a forest over vertices no triangle
+    // uses), by Kruskal's algorithm over the mesh edges sorted on `threads`
+    // threads (0 for every hardware thread). Edges come by increasing length.
+    std::vector<uint32_t> minimum_spanning_tree(const mesh_view& m, unsigned threads = 0);
+
+    /*
+    ** Vertex adjacency in compressed sparse row form: the neighbors of vertex
+    ** v are neighbors[offsets[v]] up to neighbors[offsets[v + 1]], in
+    ** counter-clockwise order around it; around a hull vertex, from the next
+    ** hull vertex to the previous one. Where several fans of triangles meet
+    ** at a vertex, as at a pinch of a masked raster, each fan is listed that
+    ** way in turn.
+     */
+    class adjacency {
+    public:
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> neighbors;
+
+        size_t size() const;
+        size_t degree(size_t v) const;
+    };
+
+    // Walks the triangles around every vertex, on `threads` threads (0 for
+    // every hardware thread)
+    adjacency vertex_adjacency(const mesh_view& m, unsigned threads = 0);
+}
@@ -0,0 +1,76 @@
+#include "hull.h"
+
+#include <algorithm>
+
+#include "trace.h"
+
+namespace delaunay {
+    namespace {
+        bool less(const point& a, const point& b) {
+            return a.x < b.x || (a.x == b.x && a.y < b.y);
+        }
+    }
+
+    std::vector<uint32_t> convex_hull(const std::vector<point>& points) {
+        if(points.empty()) return {};
+
+        trace_span span("convex hull");
+
+        /* Akl-Toussaint filter: a point strictly inside the quadrilateral
+        ** spanned by the extreme points in x and y cannot be on the hull.
+        ** The test has no branches, so the loop vectorizes, and on typical
+        ** inputs only a small fraction of the points is left to sort.
+         */
+        uint32_t left = 0, bottom = 0, right = 0, top = 0;
+        for(uint32_t i = 1; i < points.size(); ++i) {
+            if(points[i].x < points[left].x) left = i;
+            if(points[i].x > points[right].x) right = i;
+            if(points[i].y < points[bottom].y) bottom = i;
+            if(points[i].y > points[top].y) top = i;
+        }
+
+        const point quad[4] = { points[left], points[bottom], points[right], points[top] };
+
+        std::vector<uint8_t> outside(points.size());
+        for(size_t i = 0; i < points.size(); ++i) {
+            const point& p = points[i];
+            outside[i] = !((point::orientation(quad[0], quad[1], p) > 0.0) &
+                           (point::orientation(quad[1], quad[2], p) > 0.0) &
+                           (point::orientation(quad[2], quad[3], p) > 0.0) &
+                           (point::orientation(quad[3], quad[0], p) > 0.0));
+        }
+
+        std::vector<uint32_t> candidates;
+        for(uint32_t i = 0; i < points.size(); ++i) {
+            if(outside[i]) candidates.push_back(i);
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [&](uint32_t a, uint32_t b) {
+            return less(points[a], points[b]) || (!less(points[b], points[a]) && a < b);
+        });
+
+        // The chain needs distinct points, so only the first of a repeated point stays
+        candidates.erase(std::unique(candidates.begin(), candidates.end(), [&](uint32_t a, uint32_t b) {
+            return points[a].x == points[b].x && points[a].y == points[b].y;
+        }), candidates.end());
+
+        // Andrew's monotone chain: lower hull left to right, then upper hull back
+        std::vector<uint32_t> hull(2 * candidates.size());
+        size_t k = 0;
+
+        for(uint32_t i : candidates) {
+            while(k >= 2 && point::orientation(points[hull[k - 2]], points[hull[k - 1]], points[i]) <= 0.0) --k;
+            hull[k++] = i;
+        }
+
+        for(size_t i = candidates.size() - 1, lower = k + 1; i-- > 0;) {
+            uint32_t c = candidates[i];
+            while(k >= lower && point::orientation(points[hull[k - 2]], points[hull[k - 1]], points[c]) <= 0.0) --k;
+            hull[k++] = c;
+        }
+
+        // The chain ends where it started
+        hull.resize(k > 1 ? k - 1 : k);
+        return hull;
+    }
+}
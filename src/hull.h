@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "geometry.h"
+
+namespace delaunay {
+    /*
+    ** Convex hull of a point set as a counter-clockwise ring of indices into
+    ** `points`, starting at the smallest point (by x, then y). Collinear and
+    ** duplicate points on the boundary are left out. Triangulating is not
+    ** required: this is Andrew's monotone chain on the points that survive
+    ** a linear interior filter, in O(n log n).
+     */
+    std::vector<uint32_t> convex_hull(const std::vector<point>& points);
+}
@@ -0,0 +1,509 @@
+#include "io.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#include "mapped_file.h"
+#include "parallel.h"
+#include "trace.h"
+
+namespace delaunay {
+    namespace {
+        std::string extension(const std::string& path) {
+            size_t dot = path.find_last_of('.');
+            if(dot == std::string::npos) return "";
+
+            std::string ext = path.substr(dot + 1);
+            std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) {
+                return static_cast<char>(std::tolower(c));
+            });
+
+            return ext;
+        }
+
+        bool separator(char c) {
+            return c == ' ' || c == '\t' || c == ',' || c == ';' || c == '\r';
+        }
+
+        /* Read columns x_column and y_column of one line. from_chars does not
+        ** accept a leading '+', so it is skipped by hand.
+         */
+        bool parse_line(const char* p, const char* end, size_t x_column, size_t y_column, point& out) {
+            size_t last = std::max(x_column, y_column);
+
+            for(size_t column = 0; column <= last; ++column) {
+                while(p < end && separator(*p)) ++p;
+                if(p < end && *p == '+') ++p;
+
+                double value;
+                std::from_chars_result r = std::from_chars(p, end, value);
+                if(r.ec != std::errc()) return false;
+
+                if(column == x_column) out.x = value;
+                if(column == y_column) out.y = value;
+
+                p = r.ptr;
+                if(p < end && !separator(*p)) return false;
+            }
+
+            return true;
+        }
+
+        void parse_lines(const char* p, const char* end, size_t x_column, size_t y_column,
+                         std::vector<point>& out) {
+            while(p < end) {
+                const char* line_end = static_cast<const char*>(std::memchr(p, '\n', end - p));
+                if(!line_end) line_end = end;
+
+                point q;
+                if(parse_line(p, line_end, x_column, y_column, q)) out.push_back(q);
+
+                p = line_end + 1;
+            }
+        }
+
+        // Split the text into chunks at line boundaries and parse them in parallel
+        std::vector<point> parse_text(const char* begin, const char* end, size_t x_column,
+                                      size_t y_column, unsigned threads) {
+            const size_t chunk_size = 1 << 20;
+
+            unsigned workers = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+            size_t size = end - begin;
+            size_t chunks = std::max<size_t>(1, std::min<size_t>(workers * 4, size / chunk_size));
+
+            std::vector<const char*> bounds(chunks + 1, end);
+            bounds[0] = begin;
+
+            for(size_t i = 1; i < chunks; ++i) {
+                const char* p = std::max(bounds[i - 1], begin + size * i / chunks);
+                const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+
+                bounds[i] = newline ? newline + 1 : end;
+            }
+
+            std::vector<std::vector<point>> parts(chunks);
+            parallel_for(chunks, threads, [&](size_t i) {
+                trace_span span("parse", i);
+
+                parts[i].reserve((bounds[i + 1] - bounds[i]) / 16);
+                parse_lines(bounds[i], bounds[i + 1], x_column, y_column, parts[i]);
+            });
+
+            size_t total = 0;
+            for(const std::vector<point>& part : parts) total += part.size();
+
+            std::vector<point> result;
+            result.reserve(total);
+            for(const std::vector<point>& part : parts) {
+                result.insert(result.end(), part.begin(), part.end());
+            }
+
+            return result;
+        }
+
+        enum class scalar { int8, uint8, int16, uint16, int32, uint32, float32, float64 };
+
+        scalar parse_scalar(const std::string& name) {
+            if(name == "char" || name == "int8") return scalar::int8;
+            if(name == "uchar" || name == "uint8") return scalar::uint8;
+            if(name == "short" || name == "int16") return scalar::int16;
+            if(name == "ushort" || name == "uint16") return scalar::uint16;
+            if(name == "int" || name == "int32") return scalar::int32;
+            if(name == "uint" || name == "uint32") return scalar::uint32;
+            if(name == "float" || name == "float32") return scalar::float32;
+            if(name == "double" || name == "float64") return scalar::float64;
+
+            throw std::runtime_error("unknown PLY property type " + name);
+        }
+
+        size_t scalar_size(scalar type) {
+            switch(type) {
+                case scalar::int8: case scalar::uint8: return 1;
+                case scalar::int16: case scalar::uint16: return 2;
+                case scalar::int32: case scalar::uint32: case scalar::float32: return 4;
+                case scalar::float64: return 8;
+            }
+
+            return 0;
+        }
+
+        template<typename T>
+        T load(const char* p, bool swap) {
+            char bytes[sizeof(T)];
+            std::memcpy(bytes, p, sizeof(T));
+            if(swap) std::reverse(bytes, bytes + sizeof(T));
+
+            T value;
+            std::memcpy(&value, bytes, sizeof(T));
+            return value;
+        }
+
+        double decode(const char* p, scalar type, bool swap) {
+            switch(type) {
+                case scalar::int8: return load<int8_t>(p, swap);
+                case scalar::uint8: return load<uint8_t>(p, swap);
+                case scalar::int16: return load<int16_t>(p, swap);
+                case scalar::uint16: return load<uint16_t>(p, swap);
+                case scalar::int32: return load<int32_t>(p, swap);
+                case scalar::uint32: return load<uint32_t>(p, swap);
+                case scalar::float32: return load<float>(p, swap);
+                case scalar::float64: return load<double>(p, swap);
+            }
+
+            return 0.0;
+        }
+
+        class ply_element {
+        public:
+            std::string name;
+            size_t count = 0;
+            std::vector<std::string> names;
+            std::vector<scalar> types;
+            bool lists = false;
+        };
+
+        // Buffered output which formats numbers in place with to_chars
+        class output {
+        public:
+            explicit output(const std::string& path): path(path), buffer(1 << 16), used(0) {
+                file = std::fopen(path.c_str(), "wb");
+                if(!file) throw std::runtime_error("unable to open " + path);
+            }
+
+            ~output() {
+                if(file) std::fclose(file);
+            }
+
+            void write(const void* data, size_t size) {
+                if(used + size > buffer.size()) flush();
+
+                if(size > buffer.size()) {
+                    if(std::fwrite(data, 1, size, file) != size) fail();
+                    return;
+                }
+
+                std::memcpy(buffer.data() + used, data, size);
+                used += size;
+            }
+
+            void text(const char* s) {
+                write(s, std::strlen(s));
+            }
+
+            template<typename T>
+            void number(T value) {
+                // Longest shortest-round-trip double is 24 characters
+                if(used + 32 > buffer.size()) flush();
+
+                std::to_chars_result r = std::to_chars(buffer.data() + used,
+                                                       buffer.data() + buffer.size(), value);
+                used = r.ptr - buffer.data();
+            }
+
+            void character(char c) {
+                if(used == buffer.size()) flush();
+                buffer[used++] = c;
+            }
+
+            void close() {
+                flush();
+                if(std::fclose(file) != 0) {
+                    file = nullptr;
+                    fail();
+                }
+
+                file = nullptr;
+            }
+
+        private:
+            void flush() {
+                if(used && std::fwrite(buffer.data(), 1, used, file) != used) fail();
+                used = 0;
+            }
+
+            [[noreturn]] void fail() {
+                throw std::runtime_error("unable to write " + path);
+            }
+
+            std::string path;
+            std::FILE* file;
+            std::vector<char> buffer;
+            size_t used;
+        };
+    }
+
+    std::vector<point> read_xyz(const std::string& path, unsigned threads) {
+        mapped_file file(path);
+        return parse_text(file.data(), file.data() + file.size(), 0, 1, threads);
+    }
+
+    std::vector<point> read_ply(const std::string& path, unsigned threads) {
+        mapped_file file(path);
+        const char* p = file.data();
+        const char* end = p + file.size();
+
+        auto next_line = [&]() {
+            const char* line_end = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            if(!line_end) throw std::runtime_error(path + " has an incomplete PLY header");
+
+            std::string line(p, line_end);
+            if(!line.empty() && line.back() == '\r') line.pop_back();
+
+            p = line_end + 1;
+            return line;
+        };
+
+        if(next_line() != "ply") throw std::runtime_error(path + " is not a PLY file");
+
+        std::string format;
+        std::vector<ply_element> elements;
+
+        for(std::string line = next_line(); line != "end_header"; line = next_line()) {
+            std::vector<std::string> words;
+            for(size_t i = 0; i < line.size();) {
+                size_t j = line.find(' ', i);
+                if(j == std::string::npos) j = line.size();
+                if(j > i) words.push_back(line.substr(i, j - i));
+                i = j + 1;
+            }
+
+            if(words.empty() || words[0] == "comment" || words[0] == "obj_info") continue;
+
+            if(words[0] == "format" && words.size() > 1) {
+                format = words[1];
+            } else if(words[0] == "element" && words.size() > 2) {
+                ply_element e;
+                e.name = words[1];
+                e.count = std::stoull(words[2]);
+                elements.push_back(e);
+            } else if(words[0] == "property" && !elements.empty()) {
+                if(words.size() > 1 && words[1] == "list") {
+                    elements.back().lists = true;
+                    elements.back().names.push_back(words.back());
+                    elements.back().types.push_back(scalar::uint8);
+                } else if(words.size() > 2) {
+                    elements.back().names.push_back(words[2]);
+                    elements.back().types.push_back(parse_scalar(words[1]));
+                }
+            }
+        }
+
+        bool ascii = format == "ascii";
+        bool swap = format == "binary_big_endian";
+        if(!ascii && !swap && format != "binary_little_endian") {
+            throw std::runtime_error(path + " has unsupported PLY format " + format);
+        }
+
+        for(const ply_element& e : elements) {
+            if(e.name != "vertex") {
+                // Skip whatever precedes the vertices
+                if(ascii) {
+                    for(size_t i = 0; i < e.count && p < end; ++i) next_line();
+                } else if(e.lists) {
+                    throw std::runtime_error(path + ": PLY lists before the vertices are not supported");
+                } else {
+                    size_t record = 0;
+                    for(scalar type : e.types) record += scalar_size(type);
+
+                    // Compared by division, as the count is the file's word
+                    if(record && e.count > static_cast<size_t>(end - p) / record) {
+                        throw std::runtime_error(path + " is truncated");
+                    }
+
+                    p += record * e.count;
+                }
+
+                continue;
+            }
+
+            size_t x = std::find(e.names.begin(), e.names.end(), "x") - e.names.begin();
+            size_t y = std::find(e.names.begin(), e.names.end(), "y") - e.names.begin();
+            if(x == e.names.size() || y == e.names.size()) {
+                throw std::runtime_error(path + " has no x and y vertex properties");
+            }
+
+            if(ascii) {
+                // Find the end of the vertex block, then parse it in parallel
+                const char* q = p;
+                for(size_t i = 0; i < e.count && q < end; ++i) {
+                    const char* newline = static_cast<const char*>(std::memchr(q, '\n', end - q));
+                    q = newline ? newline + 1 : end;
+                }
+
+                std::vector<point> result = parse_text(p, q, x, y, threads);
+                if(result.size() != e.count) throw std::runtime_error(path + " has malformed vertices");
+
+                return result;
+            }
+
+            if(e.lists) throw std::runtime_error(path + ": PLY vertex lists are not supported");
+
+            std::vector<size_t> offsets;
+            size_t record = 0;
+            for(scalar type : e.types) {
+                offsets.push_back(record);
+                record += scalar_size(type);
+            }
+
+            if(e.count > static_cast<size_t>(end - p) / record) {
+                throw std::runtime_error(path + " is truncated");
+            }
+
+            std::vector<point> result(e.count);
+            for(size_t i = 0; i < e.count; ++i, p += record) {
+                result[i].x = decode(p + offsets[x], e.types[x], swap);
+                result[i].y = decode(p + offsets[y], e.types[y], swap);
+            }
+
+            return result;
+        }
+
+        throw std::runtime_error(path + " has no vertex element");
+    }
+
+    std::vector<point> read_las(const std::string& path) {
+        mapped_file file(path);
+        const char* data = file.data();
+
+        if(file.size() < 227 || std::memcmp(data, "LASF", 4) != 0) {
+            throw std::runtime_error(path + " is not a LAS file");
+        }
+
+        uint8_t minor = load<uint8_t>(data + 25, false);
+        uint16_t header_size = load<uint16_t>(data + 94, false);
+        uint32_t offset = load<uint32_t>(data + 96, false);
+        uint8_t format = load<uint8_t>(data + 104, false);
+        uint16_t record = load<uint16_t>(data + 105, false);
+        uint64_t count = load<uint32_t>(data + 107, false);
+
+        // LAZ marks compressed point records with the high bits of the format
+        if(format & 0xC0) throw std::runtime_error(path + " is compressed (LAZ)");
+
+        if(minor >= 4 && count == 0 && file.size() >= 255) {
+            count = load<uint64_t>(data + 247, false);
+        }
+
+        double scale_x = load<double>(data + 131, false);
+        double scale_y = load<double>(data + 139, false);
+        double offset_x = load<double>(data + 155, false);
+        double offset_y = load<double>(data + 163, false);
+
+        // The points follow the header; the count is checked by division so
+        // a hostile one cannot wrap the size
+        if(header_size < 227 || offset < header_size) {
+            throw std::runtime_error(path + " has a malformed header");
+        }
+
+        if(record < 8 || offset > file.size() || count > (file.size() - offset) / record) {
+            throw std::runtime_error(path + " is truncated");
+        }
+
+        std::vector<point> result(count);
+        const char* p = data + offset;
+        for(uint64_t i = 0; i < count; ++i, p += record) {
+            result[i].x = load<int32_t>(p, false) * scale_x + offset_x;
+            result[i].y = load<int32_t>(p + 4, false) * scale_y + offset_y;
+        }
+
+        return result;
+    }
+
+    std::vector<point> read_points(const std::string& path, unsigned threads) {
+        std::string ext = extension(path);
+
+        if(ext == "ply") return read_ply(path, threads);
+        if(ext == "las") return read_las(path);
+
+        return read_xyz(path, threads);
+    }
+
+    void write_ply(const mesh_view& m, const std::string& path, bool binary) {
+        output out(path);
+
+        out.text("ply\nformat ");
+        out.text(binary ? "binary_little_endian" : "ascii");
+        out.text(" 1.0\nelement vertex ");
+        out.number(m.vertex_count);
+        out.text("\nproperty double x\nproperty double y\nproperty double z\nelement face ");
+        out.number(m.size());
+        out.text("\nproperty list uchar int vertex_indices\nend_header\n");
+
+        for(size_t i = 0; i < m.vertex_count; ++i) {
+            const point& v = m.vertices[i];
+
+            if(binary) {
+                double xyz[3] = { v.x, v.y, 0.0 };
+                out.write(xyz, sizeof(xyz));
+            } else {
+                out.number(v.x);
+                out.character(' ');
+                out.number(v.y);
+                out.text(" 0\n");
+            }
+        }
+
+        for(size_t t = 0; t < m.size(); ++t) {
+            const uint32_t* v = m.indices + 3 * t;
+
+            if(binary) {
+                char face[13];
+                face[0] = 3;
+                for(int i = 0; i < 3; ++i) {
+                    int32_t index = static_cast<int32_t>(v[i]);
+                    std::memcpy(face + 1 + 4 * i, &index, 4);
+                }
+
+                out.write(face, sizeof(face));
+            } else {
+                out.text("3");
+                for(int i = 0; i < 3; ++i) {
+                    out.character(' ');
+                    out.number(v[i]);
+                }
+
+                out.character('\n');
+            }
+        }
+
+        out.close();
+    }
+
+    void write_obj(const mesh_view& m, const std::string& path) {
+        output out(path);
+
+        for(size_t i = 0; i < m.vertex_count; ++i) {
+            out.text("v ");
+            out.number(m.vertices[i].x);
+            out.character(' ');
+            out.number(m.vertices[i].y);
+            out.text(" 0\n");
+        }
+
+        // OBJ indices are 1-based
+        for(size_t t = 0; t < m.size(); ++t) {
+            out.character('f');
+            for(int i = 0; i < 3; ++i) {
+                out.character(' ');
+                out.number(m.indices[3 * t + i] + 1);
+            }
+
+            out.character('\n');
+        }
+
+        out.close();
+    }
+
+    void write_mesh(const mesh_view& m, const std::string& path) {
+        if(extension(path) == "obj") {
+            write_obj(m, path);
+        } else {
+            write_ply(m, path);
+        }
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "geometry.h"
+#include "mesh.h"
+
+namespace delaunay {
+    /*
+    ** Point readers. Every reader maps the file into memory; text formats
+    ** are split into chunks at line boundaries and parsed in parallel on up
+    ** to `threads` threads (0 uses every hardware thread). Only x and y are
+    ** read; any further columns or properties are skipped.
+     */
+
+    // Whitespace or comma separated columns, one point per line. Lines that
+    // do not start with two numbers (headers, comments) are skipped.
+    std::vector<point> read_xyz(const std::string& path, unsigned threads = 0);
+
+    // ASCII, binary little endian and binary big endian PLY vertices
+    std::vector<point> read_ply(const std::string& path, unsigned threads = 0);
+
+    // Uncompressed LAS 1.0 - 1.4, any point data record format
+    std::vector<point> read_las(const std::string& path);
+
+    // Pick a reader from the file extension (.ply, .las, anything else is text)
+    std::vector<point> read_points(const std::string& path, unsigned threads = 0);
+
+    /*
+    ** Mesh writers stream vertices and triangles straight into a fixed
+    ** output buffer; vertices are written with z = 0.
+     */
+    void write_ply(const mesh_view& m, const std::string& path, bool binary = true);
+    void write_obj(const mesh_view& m, const std::string& path);
+
+    // Pick a writer from the file extension (.obj, anything else is PLY)
+    void write_mesh(const mesh_view& m, const std::string& path);
+}
@@ -0,0 +1,194 @@
+#include "kernel.h"
+
+#include <algorithm>
+
+namespace delaunay {
+    namespace {
+        /* Exact arithmetic on expansions: a number is kept as a sum of
+        ** doubles, ordered by increasing magnitude and not overlapping, so
+        ** its sign is the sign of the last one.
+        **
+        ** Reference: J. R. Shewchuk, Adaptive Precision Floating-Point
+        ** Arithmetic and Fast Robust Geometric Predicates (1997)
+         */
+
+        // x + y == a + b exactly, with x the rounded sum
+        void two_sum(double a, double b, double& x, double& y) {
+            x = a + b;
+            double b_virtual = x - a;
+            double a_virtual = x - b_virtual;
+            y = (a - a_virtual) + (b - b_virtual);
+        }
+
+        void two_diff(double a, double b, double& x, double& y) {
+            x = a - b;
+            double b_virtual = a - x;
+            double a_virtual = x + b_virtual;
+            y = (a - a_virtual) + (b_virtual - b);
+        }
+
+        void two_product(double a, double b, double& x, double& y) {
+            x = a * b;
+            y = std::fma(a, b, -x);
+        }
+
+        // h = e + f, merging by magnitude; h has room for elen + flen terms
+        int sum(int elen, const double* e, int flen, const double* f, double* h) {
+            int ei = 0, fi = 0, hlen = 0;
+
+            auto smallest = [&]() {
+                if(fi == flen || (ei < elen && std::fabs(e[ei]) < std::fabs(f[fi]))) return e[ei++];
+                return f[fi++];
+            };
+
+            double q = smallest();
+            while(ei < elen || fi < flen) {
+                double rest;
+                two_sum(q, smallest(), q, rest);
+                if(rest != 0.0) h[hlen++] = rest;
+            }
+
+            if(q != 0.0 || hlen == 0) h[hlen++] = q;
+            return hlen;
+        }
+
+        // h = b * e; h has room for 2 * elen terms
+        int scale(int elen, const double* e, double b, double* h) {
+            int hlen = 0;
+            double q, rest;
+
+            two_product(e[0], b, q, rest);
+            if(rest != 0.0) h[hlen++] = rest;
+
+            for(int i = 1; i < elen; ++i) {
+                double high, low, partial;
+                two_product(e[i], b, high, low);
+
+                two_sum(q, low, partial, rest);
+                if(rest != 0.0) h[hlen++] = rest;
+
+                two_sum(high, partial, q, rest);
+                if(rest != 0.0) h[hlen++] = rest;
+            }
+
+            if(q != 0.0 || hlen == 0) h[hlen++] = q;
+            return hlen;
+        }
+
+        // h = e * f for short e and f; h has room for 2 * elen * flen terms
+        int product(int elen, const double* e, int flen, const double* f, double* h) {
+            double scaled[32], partial[512];
+
+            int hlen = scale(elen, e, f[0], h);
+            for(int j = 1; j < flen; ++j) {
+                int slen = scale(elen, e, f[j], scaled);
+                std::copy(h, h + hlen, partial);
+                hlen = sum(hlen, partial, slen, scaled, h);
+            }
+
+            return hlen;
+        }
+
+        int negate(int elen, double* e) {
+            for(int i = 0; i < elen; ++i) e[i] = -e[i];
+            return elen;
+        }
+
+        int sign(double d) {
+            return (d > 0.0) - (d < 0.0);
+        }
+
+        // a*d - b*c for exact differences; h has room for 16 terms
+        int cross(const double* a, const double* b, const double* c, const double* d, double* h) {
+            double ad[8], bc[8];
+            int adlen = product(2, a, 2, d, ad);
+            int bclen = negate(product(2, b, 2, c, bc), bc);
+
+            return sum(adlen, ad, bclen, bc, h);
+        }
+
+        // Whether a comes after b in (x, y) order
+        bool later(const point& a, const point& b) {
+            return a.x > b.x || (a.x == b.x && a.y > b.y);
+        }
+    }
+
+    int exact_kernel::exact_orientation(const point& a, const point& b, const point& c) {
+        double acx[2], acy[2], bcx[2], bcy[2];
+        two_diff(a.x, c.x, acx[1], acx[0]);
+        two_diff(a.y, c.y, acy[1], acy[0]);
+        two_diff(b.x, c.x, bcx[1], bcx[0]);
+        two_diff(b.y, c.y, bcy[1], bcy[0]);
+
+        double det[16];
+        int len = cross(acx, acy, bcx, bcy, det);
+        return sign(det[len - 1]);
+    }
+
+    int exact_kernel::exact_incircle(const point& a, const point& b, const point& c, const point& d) {
+        double dx[3][2], dy[3][2];
+        const point* v[3] = { &a, &b, &c };
+        for(int i = 0; i < 3; ++i) {
+            two_diff(v[i]->x, d.x, dx[i][1], dx[i][0]);
+            two_diff(v[i]->y, d.y, dy[i][1], dy[i][0]);
+        }
+
+        // Each lifted distance times the minor of the other two points
+        double terms[3][512];
+        int lengths[3];
+
+        for(int i = 0; i < 3; ++i) {
+            int j = (i + 1) % 3, k = (i + 2) % 3;
+
+            double xx[8], yy[8], lift[16], minor[16];
+            int xxlen = product(2, dx[i], 2, dx[i], xx);
+            int yylen = product(2, dy[i], 2, dy[i], yy);
+            int liftlen = sum(xxlen, xx, yylen, yy, lift);
+            int minorlen = cross(dx[j], dy[j], dx[k], dy[k], minor);
+
+            lengths[i] = product(liftlen, lift, minorlen, minor, terms[i]);
+        }
+
+        double partial[1024], det[1536];
+        int partiallen = sum(lengths[0], terms[0], lengths[1], terms[1], partial);
+        int len = sum(partiallen, partial, lengths[2], terms[2], det);
+
+        return sign(det[len - 1]);
+    }
+
+    bool exact_kernel::ahead(const point& f, const point& d, const point& p) {
+        double dy[2], dx[2], left[4], right[4], det[8];
+        two_diff(p.y, f.y, dy[1], dy[0]);
+        two_diff(p.x, f.x, dx[1], dx[0]);
+
+        int leftlen = scale(2, dy, d.x, left);
+        int rightlen = scale(2, dx, -d.y, right);
+        int len = sum(leftlen, left, rightlen, right, det);
+
+        return det[len - 1] > 0.0;
+    }
+
+    bool exact_kernel::perturbed_conflict(const circumcircle& c, const point& p) {
+        /* On the circle: raise every point's lifted distance by an amount
+        ** that is infinitesimal, and infinitely larger for each point later
+        ** in (x, y) order, the query point first among equals. The change
+        ** in the determinant is then decided by the latest point whose
+        ** cofactor, the orientation of the other three, is not zero.
+         */
+        const point* v[4] = { &c.v[0], &c.v[1], &c.v[2], &p };
+        int order[4] = { 3, 0, 1, 2 };
+        std::stable_sort(order, order + 4, [&](int i, int j) { return later(*v[i], *v[j]); });
+
+        for(int i : order) {
+            const point* others[3];
+            for(int j = 0, k = 0; j < 4; ++j) {
+                if(j != i) others[k++] = v[j];
+            }
+
+            int cofactor = orientation(*others[0], *others[1], *others[2]);
+            if(cofactor != 0) return (i % 2 == 0 ? cofactor : -cofactor) > 0;
+        }
+
+        return false;
+    }
+}
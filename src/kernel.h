@@ -0,0 +1,372 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "geometry.h"
+
+namespace delaunay {
+    /*
+    ** In-circle kernels of the indexed Bowyer-Watson engine, picked at
+    ** compile time (see triangulate_with): the engine is compiled once per
+    ** kernel, so the test inlines into the insertion loop without a branch
+    ** on the kind of input. A kernel keeps what it needs of a triangle,
+    ** computed once when the triangle is made:
+    **
+    **   circumcircle                  what is kept
+    **   make(a, b, c)                 for a counter-clockwise triangle
+    **   finite(circumcircle)          false for triangles touching the super
+    **                                 triangle, and collinear ones
+    **   conflicts(circumcircle, p)    p strictly inside the circumcircle
+    **   accepts(p)                    p within the kernel's bounds
+    **   beyond(a, b, p)               p strictly left of the hull edge
+    **                                 a -> b, outside the hull, so in conflict
+    **                                 with the open triangle beyond the edge
+    **   ahead(f, d, p)                p strictly left of the line through f
+    **                                 along d, a small integer direction: in
+    **                                 conflict with the open triangle of f
+    **                                 and the two ghosts joined along d
+    **   on_edge(a, b, p)              p strictly between a and b on the hull
+    **                                 edge a -> b, so in conflict with the
+    **                                 open triangle beyond it
+    **   perturbed                     whether ties on a circle are broken the
+    **                                 same way whatever the input, so lines,
+    **                                 circles and grids take no shortcut
+     */
+
+    // The circumcircle in double precision: fast for any input, but points
+    // within rounding of a circle may be judged either way
+    class circle_kernel {
+    public:
+        using circumcircle = circle;
+
+        static constexpr bool perturbed = false;
+
+        static circumcircle make(const point& a, const point& b, const point& c) {
+            return triangle(a, b, c).circumcircle();
+        }
+
+        static bool finite(const circumcircle& c) {
+            return !c.infinite();
+        }
+
+        static bool conflicts(const circumcircle& c, const point& p) {
+            double dx = p.x - c.center.x;
+            double dy = p.y - c.center.y;
+
+            return dx * dx + dy * dy < c.radius;
+        }
+
+        static bool accepts(const point&) {
+            return true;
+        }
+
+        static bool beyond(const point& a, const point& b, const point& p) {
+            return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x) > 0.0;
+        }
+
+        // Compared as the offsets of parallel lines, which orders the points
+        // consistently however they round
+        static bool ahead(const point& f, const point& d, const point& p) {
+            return d.x * p.y - d.y * p.x > d.x * f.y - d.y * f.x;
+        }
+
+        // A point computed in floating point is hardly ever exactly on a
+        // hull edge, so none is taken to be
+        static bool on_edge(const point&, const point&, const point&) {
+            return false;
+        }
+    };
+
+    /*
+    ** Integer coordinates of magnitude at most 2^26, for gridded data such
+    ** as rasters and quantized scans. Differences then take 27 bits, the
+    ** 2x2 minors and lifted distances of the in-circle determinant fit in
+    ** 64-bit integers and the determinant itself in 128 bits. The side of a
+    ** hull edge is an orientation, taken in 64-bit integers as well, since
+    ** its products need 54 bits and would round in double precision. So
+    ** every test is exact and no point is ever misjudged.
+     */
+    class grid_kernel {
+    public:
+        static constexpr double bound = 1 << 26;
+        static constexpr bool perturbed = false;
+
+        /* Signed 128-bit sum of products in two 64-bit limbs, in two's
+        ** complement, with each product put together from 32-bit halves. The
+        ** determinant uses the compiler's __int128 instead where it has one,
+        ** unless the library is built with DELAUNAY_NO_INT128 (the CMake
+        ** option of the same name).
+         */
+        class limbs {
+        public:
+            uint64_t high, low;
+
+            static limbs product(int64_t a, int64_t b) {
+                uint64_t x = a < 0 ? 0 - static_cast<uint64_t>(a) : static_cast<uint64_t>(a);
+                uint64_t y = b < 0 ? 0 - static_cast<uint64_t>(b) : static_cast<uint64_t>(b);
+
+                uint64_t x0 = x & 0xffffffff, x1 = x >> 32;
+                uint64_t y0 = y & 0xffffffff, y1 = y >> 32;
+
+                uint64_t p00 = x0 * y0, p01 = x0 * y1, p10 = x1 * y0, p11 = x1 * y1;
+                uint64_t middle = (p00 >> 32) + (p01 & 0xffffffff) + (p10 & 0xffffffff);
+
+                limbs w = { p11 + (p01 >> 32) + (p10 >> 32) + (middle >> 32),
+                            (middle << 32) | (p00 & 0xffffffff) };
+
+                // Negate as ~w + 1, carrying into the high limb when the low one is 0
+                if((a < 0) != (b < 0)) {
+                    w.high = ~w.high + (w.low == 0);
+                    w.low = 0 - w.low;
+                }
+
+                return w;
+            }
+
+            limbs operator+(const limbs& other) const {
+                uint64_t low_sum = low + other.low;
+                return { high + other.high + (low_sum < low), low_sum };
+            }
+
+            bool positive() const {
+                return (high >> 63) == 0 && (high | low) != 0;
+            }
+        };
+
+#if defined(__SIZEOF_INT128__) && !defined(DELAUNAY_NO_INT128)
+        class wide {
+        public:
+            __int128 value;
+
+            static wide product(int64_t a, int64_t b) {
+                return { static_cast<__int128>(a) * b };
+            }
+
+            wide operator+(const wide& other) const {
+                return { value + other.value };
+            }
+
+            bool positive() const {
+                return value > 0;
+            }
+        };
+#else
+        using wide = limbs;
+#endif
+
+        class circumcircle {
+        public:
+            int64_t x[3], y[3];
+            bool finite;
+        };
+
+        static circumcircle make(const point& a, const point& b, const point& c) {
+            circumcircle k = {};
+            if(!a.finite() || !b.finite() || !c.finite()) return k;
+
+            const point* v[3] = { &a, &b, &c };
+            for(int i = 0; i < 3; ++i) {
+                k.x[i] = static_cast<int64_t>(v[i]->x);
+                k.y[i] = static_cast<int64_t>(v[i]->y);
+            }
+
+            k.finite = (k.x[1] - k.x[0]) * (k.y[2] - k.y[0]) != (k.x[2] - k.x[0]) * (k.y[1] - k.y[0]);
+            return k;
+        }
+
+        static bool finite(const circumcircle& c) {
+            return c.finite;
+        }
+
+        static bool conflicts(const circumcircle& c, const point& p) {
+            int64_t px = static_cast<int64_t>(p.x), py = static_cast<int64_t>(p.y);
+
+            int64_t adx = c.x[0] - px, ady = c.y[0] - py;
+            int64_t bdx = c.x[1] - px, bdy = c.y[1] - py;
+            int64_t cdx = c.x[2] - px, cdy = c.y[2] - py;
+
+            wide det = wide::product(adx * adx + ady * ady, bdx * cdy - cdx * bdy)
+                     + wide::product(bdx * bdx + bdy * bdy, cdx * ady - adx * cdy)
+                     + wide::product(cdx * cdx + cdy * cdy, adx * bdy - bdx * ady);
+
+            return det.positive();
+        }
+
+        static bool accepts(const point& p) {
+            return std::fabs(p.x) <= bound && std::fabs(p.y) <= bound &&
+                   p.x == std::floor(p.x) && p.y == std::floor(p.y);
+        }
+
+        static bool beyond(const point& a, const point& b, const point& p) {
+            int64_t dx = static_cast<int64_t>(b.x) - static_cast<int64_t>(a.x);
+            int64_t dy = static_cast<int64_t>(b.y) - static_cast<int64_t>(a.y);
+            int64_t px = static_cast<int64_t>(p.x) - static_cast<int64_t>(a.x);
+            int64_t py = static_cast<int64_t>(p.y) - static_cast<int64_t>(a.y);
+
+            return dx * py > dy * px;
+        }
+
+        static bool ahead(const point& f, const point& d, const point& p) {
+            int64_t dx = static_cast<int64_t>(d.x), dy = static_cast<int64_t>(d.y);
+            int64_t px = static_cast<int64_t>(p.x) - static_cast<int64_t>(f.x);
+            int64_t py = static_cast<int64_t>(p.y) - static_cast<int64_t>(f.y);
+
+            return dx * py > dy * px;
+        }
+
+        // Otherwise a point on a hull edge only conflicts with the triangle
+        // inside, and is joined to the edge in a flat triangle
+        static bool on_edge(const point& a, const point& b, const point& p) {
+            int64_t dx = static_cast<int64_t>(b.x) - static_cast<int64_t>(a.x);
+            int64_t dy = static_cast<int64_t>(b.y) - static_cast<int64_t>(a.y);
+            int64_t px = static_cast<int64_t>(p.x) - static_cast<int64_t>(a.x);
+            int64_t py = static_cast<int64_t>(p.y) - static_cast<int64_t>(a.y);
+
+            if(dx * py != dy * px) return false;
+
+            int64_t along = dx * px + dy * py;
+            return along > 0 && along < dx * dx + dy * dy;
+        }
+    };
+
+    /*
+    ** Any finite coordinates, with every test exact: taken in double
+    ** precision when the rounding error cannot change its sign, and in
+    ** exact expansion arithmetic otherwise. A point exactly on a
+    ** circumcircle is decided by symbolic perturbation, as if every point
+    ** were lifted an infinitesimal amount that grows with its (x, y)
+    ** order. The triangulation is then unique, whatever the insertion order
+    ** or the other points around, so overlapping subsets of the points
+    ** (the tiles of triangulate_tiled) agree on every triangle they share.
+     */
+    class exact_kernel {
+    public:
+        /* With q = p - v[0], the in-circle determinant is
+        ** q.x * minors[0] - q.y * minors[1] + |q|^2 * minors[2], taken
+        ** in double precision as long as it is further from 0 than the
+        ** rounding error, bounded through the minors' permanents.
+         */
+        class circumcircle {
+        public:
+            point v[3];
+            bool finite;
+            double minors[3], permanents[3];
+        };
+
+        static constexpr bool perturbed = true;
+
+        // Sign of the orientation of a, b, c: positive when counter-clockwise
+        static int orientation(const point& a, const point& b, const point& c) {
+            double left = (a.x - c.x) * (b.y - c.y);
+            double right = (a.y - c.y) * (b.x - c.x);
+            double det = left - right;
+
+            if(std::fabs(det) > orientation_bound * (std::fabs(left) + std::fabs(right))) {
+                return (det > 0.0) - (det < 0.0);
+            }
+
+            return exact_orientation(a, b, c);
+        }
+
+        // Sign of the in-circle determinant: positive when d is inside the
+        // circle through the counter-clockwise a, b, c, 0 on it
+        static int incircle(const point& a, const point& b, const point& c, const point& d) {
+            double adx = a.x - d.x, ady = a.y - d.y;
+            double bdx = b.x - d.x, bdy = b.y - d.y;
+            double cdx = c.x - d.x, cdy = c.y - d.y;
+
+            double alift = adx * adx + ady * ady;
+            double blift = bdx * bdx + bdy * bdy;
+            double clift = cdx * cdx + cdy * cdy;
+
+            double det = alift * (bdx * cdy - cdx * bdy)
+                       + blift * (cdx * ady - adx * cdy)
+                       + clift * (adx * bdy - bdx * ady);
+
+            double permanent = alift * (std::fabs(bdx * cdy) + std::fabs(cdx * bdy))
+                             + blift * (std::fabs(cdx * ady) + std::fabs(adx * cdy))
+                             + clift * (std::fabs(adx * bdy) + std::fabs(bdx * ady));
+
+            if(std::fabs(det) > incircle_bound * permanent) return (det > 0.0) - (det < 0.0);
+
+            return exact_incircle(a, b, c, d);
+        }
+
+        static circumcircle make(const point& a, const point& b, const point& c) {
+            circumcircle k = { { a, b, c }, false, {}, {} };
+            if(!a.finite() || !b.finite() || !c.finite() || orientation(a, b, c) == 0) return k;
+
+            double bx = b.x - a.x, by = b.y - a.y, cx = c.x - a.x, cy = c.y - a.y;
+            double blift = bx * bx + by * by, clift = cx * cx + cy * cy;
+
+            // Negated, so that points inside come out positive
+            k.minors[0] = blift * cy - by * clift;
+            k.minors[1] = blift * cx - bx * clift;
+            k.minors[2] = by * cx - bx * cy;
+
+            k.permanents[0] = blift * std::fabs(cy) + std::fabs(by) * clift;
+            k.permanents[1] = blift * std::fabs(cx) + std::fabs(bx) * clift;
+            k.permanents[2] = std::fabs(by * cx) + std::fabs(bx * cy);
+
+            k.finite = true;
+            return k;
+        }
+
+        static bool finite(const circumcircle& c) {
+            return c.finite;
+        }
+
+        static bool conflicts(const circumcircle& c, const point& p) {
+            double qx = p.x - c.v[0].x, qy = p.y - c.v[0].y;
+            double qlift = qx * qx + qy * qy;
+
+            double det = qx * c.minors[0] - qy * c.minors[1] + qlift * c.minors[2];
+            double permanent = std::fabs(qx) * c.permanents[0] + std::fabs(qy) * c.permanents[1]
+                             + qlift * c.permanents[2];
+
+            if(std::fabs(det) > circle_bound * permanent) return det > 0.0;
+
+            int side = incircle(c.v[0], c.v[1], c.v[2], p);
+            return side != 0 ? side > 0 : perturbed_conflict(c, p);
+        }
+
+        static bool accepts(const point& p) {
+            return p.finite();
+        }
+
+        static bool beyond(const point& a, const point& b, const point& p) {
+            return orientation(a, b, p) > 0;
+        }
+
+        static bool ahead(const point& f, const point& d, const point& p);
+
+        // Collinear points are not perturbed, and one on a hull edge is
+        // joined to both of its ends
+        static bool on_edge(const point& a, const point& b, const point& p) {
+            if(orientation(a, b, p) != 0) return false;
+
+            if(a.x != b.x) return std::min(a.x, b.x) < p.x && p.x < std::max(a.x, b.x);
+            return std::min(a.y, b.y) < p.y && p.y < std::max(a.y, b.y);
+        }
+
+    private:
+        // How far a determinant taken in double precision can be off,
+        // relative to the sum of the magnitudes of its terms (half an ulp
+        // of 1 being the largest relative rounding error)
+        static constexpr double epsilon = 1.0 / (1ull << 53);
+        static constexpr double orientation_bound = (3.0 + 16.0 * epsilon) * epsilon;
+        static constexpr double incircle_bound = (10.0 + 96.0 * epsilon) * epsilon;
+
+        // The same for the circumcircle's minors, each term of which goes
+        // through at most 11 roundings
+        static constexpr double circle_bound = 16.0 * epsilon;
+
+        // The exact fallbacks, for when the rounding error could change the sign
+        static int exact_orientation(const point& a, const point& b, const point& c);
+        static int exact_incircle(const point& a, const point& b, const point& c, const point& d);
+
+        // The tie on the circle, broken by perturbation
+        static bool perturbed_conflict(const circumcircle& c, const point& p);
+    };
+}
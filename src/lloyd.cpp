@@ -0,0 +1,128 @@
+#include "lloyd.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "delaunay.h"
+#include "parallel.h"
+#include "power.h"
+#include "trace.h"
+
+namespace delaunay {
+    namespace {
+        // Vertices per unit of parallel work
+        const size_t chunk = 4096;
+
+        // Centroid of a counter-clockwise polygon, or false when it has no area
+        bool centroid(const point* polygon, size_t size, point& result) {
+            double area = 0.0, x = 0.0, y = 0.0;
+
+            for(size_t i = 0; i < size; ++i) {
+                const point& p = polygon[i];
+                const point& q = polygon[(i + 1) % size];
+
+                double cross = p.x * q.y - q.x * p.y;
+                area += cross;
+                x += (p.x + q.x) * cross;
+                y += (p.y + q.y) * cross;
+            }
+
+            if(!(area > 0.0)) return false;
+
+            result = point(x / (3.0 * area), y / (3.0 * area));
+            return true;
+        }
+    }
+
+    relaxation::relaxation(size_t iterations, double tolerance, unsigned threads):
+        iterations(iterations), tolerance(tolerance), threads(threads) {}
+
+    size_t relax(mesh& m, const point& min, const point& max, const relaxation& options) {
+        trace_span span("relax");
+
+        double limit = options.tolerance * std::sqrt(min.distance_squared(max));
+        size_t count = m.vertices.size();
+        if(count == 0) return 0;
+
+        // Where each vertex was headed, and for how many iterations it was held back
+        std::vector<point> targets;
+        std::vector<uint32_t> waiting(count, 0);
+
+        for(size_t iteration = 0; iteration < options.iterations; ++iteration) {
+            trace_span iteration_span("iteration", iteration);
+
+            power_diagram cells = power_cells(m, {}, min, max, options.threads);
+            std::vector<point> previous = m.vertices;
+
+            // Move every vertex to its centroid, keeping the largest step per chunk
+            std::vector<double> steps((count + chunk - 1) / chunk, 0.0);
+            targets = m.vertices;
+
+            parallel_for(steps.size(), options.threads, [&](size_t part) {
+                for(size_t v = part * chunk; v < std::min(count, (part + 1) * chunk); ++v) {
+                    point target;
+                    uint32_t offset = cells.offsets[v];
+                    if(!centroid(cells.vertices.data() + offset, cells.offsets[v + 1] - offset, target)) continue;
+
+                    steps[part] = std::max(steps[part], m.vertices[v].distance_squared(target));
+                    m.vertices[v] = targets[v] = target;
+                }
+            });
+
+            double step = std::sqrt(*std::max_element(steps.begin(), steps.end()));
+
+            /* Flips cannot repair an inverted triangle (except at the hull,
+            ** see mesh::repairable), so the vertices of one only go half as
+            ** far, and after a few tries stay where they
+            ** were. With every vertex back, the mesh is valid again.
+             */
+            std::vector<uint8_t> held(count, 0);
+
+            for(int attempt = 0;; ++attempt) {
+                bool inverted = false;
+
+                for(size_t t = 0; t < m.size(); ++t) {
+                    const uint32_t* v = &m.indices[3 * t];
+                    if(point::orientation(m.vertices[v[0]], m.vertices[v[1]], m.vertices[v[2]]) > 0.0) continue;
+
+                    if(m.repairable(static_cast<uint32_t>(t))) continue;
+
+                    for(int k = 0; k < 3; ++k) {
+                        point& p = m.vertices[v[k]];
+                        if(p.x == previous[v[k]].x && p.y == previous[v[k]].y) continue;
+
+                        p = attempt < 4 ? point::midpoint(previous[v[k]], p) : previous[v[k]];
+                        held[v[k]] = 1;
+                        inverted = true;
+                    }
+                }
+
+                if(!inverted) break;
+            }
+
+            // Vertices held back for several iterations in a row are stuck
+            // behind the hull; only a rebuild moves them on
+            bool stuck = false;
+            for(size_t v = 0; v < count; ++v) {
+                waiting[v] = held[v] ? waiting[v] + 1 : 0;
+                stuck |= waiting[v] > 3;
+            }
+
+            if(stuck || !m.restore_delaunay(4 * m.indices.size())) {
+                trace_span rebuild_span("rebuild");
+
+                std::vector<point> vertices = std::move(m.vertices);
+                for(size_t v = 0; v < count; ++v) {
+                    if(waiting[v]) vertices[v] = targets[v];
+                }
+
+                m = triangulate_mesh(vertices);
+                std::fill(waiting.begin(), waiting.end(), 0);
+            }
+
+            if(step <= limit) return iteration + 1;
+        }
+
+        return options.iterations;
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+
+#include "geometry.h"
+#include "mesh.h"
+
+namespace delaunay {
+    class relaxation {
+    public:
+        // Upper bound on the number of iterations
+        size_t iterations;
+
+        // Stop once no vertex moves further than this fraction of the box
+        // diagonal in one iteration
+        double tolerance;
+
+        // Worker threads for the cells and centroids, 0 for every hardware thread
+        unsigned threads;
+
+        relaxation(size_t iterations = 100, double tolerance = 1e-4, unsigned threads = 0);
+    };
+
+    /*
+    ** Lloyd's algorithm towards a centroidal Voronoi tessellation: move every
+    ** vertex of a Delaunay mesh to the centroid of its Voronoi cell clipped
+    ** to the box from `min` to `max`, and repeat. The mesh is kept and
+    ** repaired by edge flips after each step. Vertices whose step would
+    ** invert a triangle or dent the hull wait for the next iteration, and the
+    ** mesh is only rebuilt when flipping does not settle. Returns the number
+    ** of iterations run.
+     */
+    size_t relax(mesh& m, const point& min, const point& max, const relaxation& options = relaxation());
+}
@@ -0,0 +1,577 @@
+#include "locate.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+#include "delaunay.h"
+#include "parallel.h"
+#include "reorder.h"
+#include "trace.h"
+
+namespace delaunay {
+    namespace {
+        const uint32_t none = mesh::none;
+
+        /* Where a walk towards p ended: the triangle holding p, or a
+        ** triangle on the hull with `exit` the slot of its hull edge that p
+        ** lies beyond.
+         */
+        class location {
+        public:
+            uint32_t triangle;
+            uint32_t exit;
+        };
+
+        /* Visibility walk: step across any edge that p lies strictly beyond,
+        ** never straight back, trying the edges in a rotating order so that
+        ** no walk can circle forever.
+         */
+        location walk(const mesh_view& m, const point& p, uint32_t t) {
+            uint32_t from = none;
+
+            for(uint32_t step = 0;; ++step) {
+                uint32_t to = none;
+
+                for(uint32_t k = 0; k < 3; ++k) {
+                    uint32_t slot = 3 * t + (k + step) % 3;
+                    uint32_t across = m.neighbors[slot];
+                    if(across != none && across == from) continue;
+
+                    if(point::orientation(m.vertices[m.indices[slot]], m.vertices[m.indices[mesh::next(slot)]], p) < 0.0) {
+                        if(across == none) return location{ t, slot };
+
+                        to = across;
+                        break;
+                    }
+                }
+
+                if(to == none) return location{ t, none };
+
+                from = t;
+                t = to;
+            }
+        }
+
+        /* Call visit(slot) with a slot of every vertex sharing an edge with
+        ** the vertex at `slot`: counter-clockwise around it, and if that runs
+        ** into the hull, clockwise from the start too.
+         */
+        template<typename visitor>
+        void each_neighbor(const mesh_view& m, uint32_t slot, visitor visit) {
+            uint32_t v = m.indices[slot];
+
+            for(uint32_t s = slot;;) {
+                visit(mesh::next(s));
+
+                uint32_t around = m.next_around(s);
+                if(around == none) {
+                    visit(mesh::previous(s));
+                    break;
+                }
+
+                s = around;
+                if(s == slot) return;
+            }
+
+            for(uint32_t s = slot;;) {
+                uint32_t t = m.neighbors[s];
+                if(t == none) return;
+
+                s = m.corner(t, v);
+                visit(mesh::next(s));
+            }
+        }
+
+        // Hull edge leaving the head of hull edge `slot`
+        uint32_t next_hull_edge(const mesh& m, uint32_t slot) {
+            uint32_t v = m.indices[mesh::next(slot)], s = mesh::next(slot);
+            while(m.neighbors[s] != none) s = m.corner(m.neighbors[s], v);
+
+            return s;
+        }
+
+        // Hull edge arriving at the tail of hull edge `slot`
+        uint32_t previous_hull_edge(const mesh& m, uint32_t slot) {
+            uint32_t v = m.indices[slot], s = mesh::previous(slot);
+            while(m.neighbors[s] != none) s = mesh::previous(m.corner(m.neighbors[s], v));
+
+            return s;
+        }
+    }
+
+    uint32_t locate(const mesh_view& m, const point& p, uint32_t hint) {
+        if(m.size() == 0) return none;
+
+        location at = walk(m, p, hint < m.size() ? hint : 0);
+        return at.exit == none ? at.triangle : none;
+    }
+
+    uint32_t nearest_vertex(const mesh_view& m, const point& p, uint32_t hint) {
+        if(m.size() == 0) return none;
+
+        uint32_t t = walk(m, p, hint < m.size() ? hint : 0).triangle;
+
+        uint32_t slot = 3 * t;
+        double closest = m.vertices[m.indices[slot]].distance_squared(p);
+
+        for(uint32_t i = 1; i < 3; ++i) {
+            double distance = m.vertices[m.indices[3 * t + i]].distance_squared(p);
+            if(distance < closest) {
+                closest = distance;
+                slot = 3 * t + i;
+            }
+        }
+
+        /* A vertex none of whose Delaunay neighbors is closer to p is the
+        ** closest of all, so greedy steps along the edges reach it.
+         */
+        for(;;) {
+            uint32_t best = none;
+
+            each_neighbor(m, slot, [&](uint32_t s) {
+                double distance = m.vertices[m.indices[s]].distance_squared(p);
+                if(distance < closest) {
+                    closest = distance;
+                    best = s;
+                }
+            });
+
+            if(best == none) break;
+            slot = best;
+        }
+
+        return m.indices[slot];
+    }
+
+    double interpolate(const mesh_view& m, const std::vector<double>& values, const point& p,
+                       uint32_t hint) {
+        uint32_t t = locate(m, p, hint);
+        if(t == none) return std::numeric_limits<double>::quiet_NaN();
+
+        const uint32_t* v = &m.indices[3 * t];
+        const point& a = m.vertices[v[0]];
+        const point& b = m.vertices[v[1]];
+        const point& c = m.vertices[v[2]];
+
+        // Barycentric coordinates are the areas opposite each vertex
+        double area = point::orientation(a, b, c);
+        double wa = point::orientation(b, c, p) / area, wb = point::orientation(c, a, p) / area;
+
+        return wa * values[v[0]] + wb * values[v[1]] + (1.0 - wa - wb) * values[v[2]];
+    }
+
+    namespace {
+        /* Edge around a cavity: the new triangle (a, b, p) is counter-clockwise
+        ** with `outer` across a -> b.
+         */
+        class side {
+        public:
+            uint32_t a, b, outer;
+            uint8_t constrained;
+        };
+
+        // What inserting a point replaces, found without changing the mesh
+        class cavity {
+        public:
+            // Triangles whose circumcircle holds the point
+            std::vector<uint32_t> triangles;
+
+            // Hull edges the point sees or lies on, in hull order
+            std::vector<uint32_t> visible;
+            uint32_t first_seen;
+
+            std::vector<side> sides;
+        };
+
+        /* Find the cavity of p, walking from `hint`, which is left at the
+        ** triangle holding p. Returns the vertex already at p, if any.
+         */
+        uint32_t find_cavity(const mesh& m, const point& p, uint32_t& hint, cavity& found) {
+            location at = walk(m, p, hint);
+            uint32_t t = hint = at.triangle;
+
+            for(uint32_t k = 0; k < 3; ++k) {
+                if(m.vertices[m.indices[3 * t + k]] == p) return m.indices[3 * t + k];
+            }
+
+            /* The hull edges p sees, in hull order, are the ones replaced by p
+            ** on the hull (as are edges p lies on). The walk ends at one of
+            ** them, if any.
+             */
+            uint32_t seen = at.exit;
+            for(uint32_t k = 0; k < 3 && seen == none; ++k) {
+                uint32_t slot = 3 * t + k;
+                if(m.neighbors[slot] != none) continue;
+
+                if(point::orientation(m.vertices[m.indices[slot]], m.vertices[m.indices[mesh::next(slot)]], p) == 0.0) seen = slot;
+            }
+
+            auto sees = [&](uint32_t slot) {
+                return point::orientation(m.vertices[m.indices[slot]], m.vertices[m.indices[mesh::next(slot)]], p) < 0.0;
+            };
+
+            // Seen edges are contiguous on the (convex) hull
+            std::vector<uint32_t>& visible = found.visible;
+            visible.clear();
+
+            if(seen != none) {
+                visible.push_back(seen);
+
+                for(uint32_t s = next_hull_edge(m, seen); s != seen && sees(s); s = next_hull_edge(m, s)) {
+                    visible.push_back(s);
+                }
+
+                for(uint32_t s = previous_hull_edge(m, seen); s != visible.back() && sees(s); s = previous_hull_edge(m, s)) {
+                    visible.insert(visible.begin(), s);
+                }
+            }
+
+            found.first_seen = visible.empty() ? none : m.indices[visible.front()];
+
+            auto is_visible = [&](uint32_t slot) {
+                return std::find(visible.begin(), visible.end(), slot) != visible.end();
+            };
+
+            // Triangles whose circumcircle holds p, grown from where p was found
+            std::vector<uint32_t>& triangles = found.triangles;
+            triangles.clear();
+
+            auto in_cavity = [&](uint32_t u) {
+                return std::find(triangles.begin(), triangles.end(), u) != triangles.end();
+            };
+
+            auto conflicts = [&](uint32_t u) {
+                return m.at(u).circumcircle().contains(p);
+            };
+
+            if(visible.empty()) triangles.push_back(t);
+
+            for(uint32_t s : visible) {
+                // A triangle p lies on the edge of is always replaced
+                bool on_edge = !sees(s);
+                if(!in_cavity(s / 3) && (on_edge || conflicts(s / 3))) triangles.push_back(s / 3);
+            }
+
+            for(size_t i = 0; i < triangles.size(); ++i) {
+                for(uint32_t k = 0; k < 3; ++k) {
+                    uint32_t u = m.neighbors[3 * triangles[i] + k];
+                    if(u != none && !in_cavity(u) && conflicts(u)) triangles.push_back(u);
+                }
+            }
+
+            // New triangles join p to the edges around the cavity and to the
+            // visible hull edges left outside it
+            found.sides.clear();
+            for(uint32_t c : triangles) {
+                for(uint32_t k = 0; k < 3; ++k) {
+                    uint32_t slot = 3 * c + k;
+                    uint32_t u = m.neighbors[slot];
+                    if(u != none ? in_cavity(u) : is_visible(slot)) continue;
+
+                    uint8_t constrained = (m.constraints[c] >> k) & 1;
+                    found.sides.push_back(side{ m.indices[slot], m.indices[mesh::next(slot)], u, constrained });
+                }
+            }
+
+            for(uint32_t s : visible) {
+                if(in_cavity(s / 3)) continue;
+
+                uint8_t constrained = (m.constraints[s / 3] >> (s % 3)) & 1;
+                found.sides.push_back(side{ m.indices[mesh::next(s)], m.indices[s], s / 3, constrained });
+            }
+
+            return none;
+        }
+
+        /* Replace the cavity by triangles around vertex v. The cavity's
+        ** triangles are reused and the rest numbered from `first`; the
+        ** arrays must already hold them.
+         */
+        void fill_cavity(mesh& m, uint32_t v, const cavity& found, uint32_t first) {
+            const std::vector<side>& sides = found.sides;
+            const std::vector<uint32_t>& triangles = found.triangles;
+
+            std::vector<uint32_t> created(sides.size());
+            for(size_t j = 0; j < sides.size(); ++j) {
+                created[j] = j < triangles.size() ? triangles[j] : static_cast<uint32_t>(first + j - triangles.size());
+            }
+
+            for(size_t j = 0; j < sides.size(); ++j) {
+                const side& e = sides[j];
+                uint32_t n = created[j];
+
+                m.indices[3 * n] = e.a;
+                m.indices[3 * n + 1] = e.b;
+                m.indices[3 * n + 2] = v;
+                m.neighbors[3 * n] = e.outer;
+                m.neighbors[3 * n + 1] = none;
+                m.neighbors[3 * n + 2] = none;
+                m.constraints[n] = e.constrained;
+
+                if(e.outer == none) continue;
+
+                for(uint32_t k = 0; k < 3; ++k) {
+                    uint32_t slot = 3 * e.outer + k;
+                    if(m.indices[slot] == e.b && m.indices[mesh::next(slot)] == e.a) m.neighbors[slot] = n;
+                }
+            }
+
+            // Around v, the triangle on edge b -> v starts at b
+            for(size_t j = 0; j < sides.size(); ++j) {
+                for(size_t i = 0; i < sides.size(); ++i) {
+                    if(sides[i].a == sides[j].b) m.neighbors[3 * created[j] + 1] = created[i];
+                    if(sides[i].b == sides[j].a) m.neighbors[3 * created[j] + 2] = created[i];
+                }
+            }
+
+            if(!found.visible.empty()) {
+                // v takes the place of the vertices between the visible edges
+                auto at = std::find(m.hull.begin(), m.hull.end(), found.first_seen);
+                std::rotate(m.hull.begin(), at, m.hull.end());
+
+                m.hull.erase(m.hull.begin() + 1, m.hull.begin() + found.visible.size());
+                m.hull.insert(m.hull.begin() + 1, v);
+            }
+        }
+
+        void resize(mesh& m, size_t count) {
+            m.indices.resize(3 * count);
+            m.neighbors.resize(3 * count);
+            m.constraints.resize(count);
+        }
+    }
+
+    uint32_t insert(mesh& m, const point& p, uint32_t hint) {
+        // Without any triangle yet there is no structure to insert into
+        if(m.size() == 0) {
+            m.vertices.push_back(p);
+
+            mesh rebuilt = triangulate_mesh(m.vertices);
+            std::swap(m, rebuilt);
+
+            return static_cast<uint32_t>(m.vertices.size() - 1);
+        }
+
+        cavity found;
+        if(hint >= m.size()) hint = 0;
+
+        uint32_t existing = find_cavity(m, p, hint, found);
+        if(existing != none) return existing;
+
+        const uint32_t v = static_cast<uint32_t>(m.vertices.size());
+        m.vertices.push_back(p);
+
+        uint32_t first = static_cast<uint32_t>(m.size());
+        resize(m, m.size() + found.sides.size() - found.triangles.size());
+        fill_cavity(m, v, found, first);
+
+        return v;
+    }
+
+    std::vector<uint32_t> insert(mesh& m, const std::vector<point>& points, unsigned threads) {
+        trace_span span("batch insert");
+
+        // Points per unit of parallel work
+        const size_t chunk = 64;
+
+        std::vector<uint32_t> result(points.size(), none);
+
+        if(m.size() == 0) {
+            for(size_t i = 0; i < points.size(); ++i) {
+                result[i] = insert(m, points[i], m.size() ? static_cast<uint32_t>(m.size() - 1) : 0);
+            }
+
+            return result;
+        }
+
+        /* Point i becomes vertex n + i. Every point inside the hull adds two
+        ** triangles, so the arrays are sized for all of them up front and new
+        ** triangles are numbered from an atomic counter.
+         */
+        const uint32_t n = static_cast<uint32_t>(m.vertices.size());
+        m.vertices.insert(m.vertices.end(), points.begin(), points.end());
+
+        size_t capacity = m.size() + 2 * points.size();
+        uint32_t used = static_cast<uint32_t>(m.size());
+
+        // Locate every point once, walking from one to the next along a
+        // Hilbert curve; the triangles found stay good hints as the mesh grows
+        std::vector<uint32_t> hints(points.size(), 0);
+        std::vector<uint32_t> order = hilbert_order(points, threads);
+
+        parallel_for((order.size() + 1023) / 1024, threads, [&](size_t part) {
+            uint32_t hint = 0;
+            for(size_t j = part * 1024; j < std::min(order.size(), (part + 1) * 1024); ++j) {
+                hint = hints[order[j]] = walk(m, points[order[j]], hint).triangle;
+            }
+        });
+
+        resize(m, capacity);
+
+        /* Highest priority (lowest position in the window) of the points that
+        ** would replace each triangle, and of the points that would replace
+        ** or relink it. Only relinking different edges of one triangle does
+        ** not conflict.
+         */
+        std::vector<std::atomic<uint32_t>> replacing(capacity), touching(capacity);
+        for(size_t t = 0; t < capacity; ++t) {
+            replacing[t].store(none, std::memory_order_relaxed);
+            touching[t].store(none, std::memory_order_relaxed);
+        }
+
+        auto claim = [](std::atomic<uint32_t>& owner, uint32_t i) {
+            uint32_t current = owner.load();
+            while(i < current && !owner.compare_exchange_weak(current, i)) {}
+        };
+
+        std::vector<uint32_t> pending(points.size()), deferred;
+        for(uint32_t i = 0; i < points.size(); ++i) pending[i] = i;
+
+        enum { waiting, won, inserted, finished, outside };
+
+        std::vector<cavity> cavities;
+        std::vector<uint8_t> state;
+        std::vector<uint32_t> firsts;
+
+        while(!pending.empty()) {
+            trace_span round("insert round");
+
+            // Enough points to keep every thread busy, few enough to mostly not collide
+            size_t window = std::min(pending.size(), std::max<size_t>(256, used / 8));
+            size_t parts = (window + chunk - 1) / chunk;
+
+            cavities.resize(window);
+            state.assign(window, waiting);
+            firsts.resize(window);
+
+            parallel_for(parts, threads, [&](size_t part) {
+                for(size_t i = part * chunk; i < std::min(window, (part + 1) * chunk); ++i) {
+                    uint32_t id = pending[i];
+
+                    uint32_t existing = find_cavity(m, points[id], hints[id], cavities[i]);
+                    if(existing != none) {
+                        result[id] = existing;
+                        state[i] = finished;
+                        continue;
+                    }
+
+                    if(!cavities[i].visible.empty()) {
+                        state[i] = outside;
+                        continue;
+                    }
+
+                    for(uint32_t t : cavities[i].triangles) {
+                        claim(replacing[t], static_cast<uint32_t>(i));
+                        claim(touching[t], static_cast<uint32_t>(i));
+                    }
+
+                    for(const side& e : cavities[i].sides) {
+                        if(e.outer != none) claim(touching[e.outer], static_cast<uint32_t>(i));
+                    }
+                }
+            });
+
+            parallel_for(parts, threads, [&](size_t part) {
+                for(size_t i = part * chunk; i < std::min(window, (part + 1) * chunk); ++i) {
+                    if(state[i] != waiting) continue;
+
+                    bool all = true;
+                    for(uint32_t t : cavities[i].triangles) all &= touching[t].load() == i;
+                    for(const side& e : cavities[i].sides) all &= e.outer == none || replacing[e.outer].load() > i;
+
+                    if(all) state[i] = won;
+                }
+            });
+
+            // New triangles numbered in window order, whichever thread wins
+            for(size_t i = 0; i < window; ++i) {
+                if(state[i] != won) continue;
+
+                firsts[i] = used;
+                used += static_cast<uint32_t>(cavities[i].sides.size() - cavities[i].triangles.size());
+            }
+
+            // Winners write only to triangles they own and to new ones
+            parallel_for(parts, threads, [&](size_t part) {
+                for(size_t i = part * chunk; i < std::min(window, (part + 1) * chunk); ++i) {
+                    if(state[i] != won) continue;
+
+                    fill_cavity(m, n + pending[i], cavities[i], firsts[i]);
+                    result[pending[i]] = n + pending[i];
+                    state[i] = inserted;
+                }
+            });
+
+            parallel_for(parts, threads, [&](size_t part) {
+                for(size_t i = part * chunk; i < std::min(window, (part + 1) * chunk); ++i) {
+                    if(state[i] != waiting && state[i] != inserted) continue;
+
+                    for(uint32_t t : cavities[i].triangles) {
+                        replacing[t].store(none, std::memory_order_relaxed);
+                        touching[t].store(none, std::memory_order_relaxed);
+                    }
+
+                    for(const side& e : cavities[i].sides) {
+                        if(e.outer != none) touching[e.outer].store(none, std::memory_order_relaxed);
+                    }
+                }
+            });
+
+            // Losers go first in the next round, in their order
+            size_t kept = 0;
+            for(size_t i = 0; i < window; ++i) {
+                if(state[i] == waiting) pending[kept++] = pending[i];
+                if(state[i] == outside) deferred.push_back(pending[i]);
+            }
+
+            pending.erase(pending.begin() + kept, pending.begin() + window);
+        }
+
+        resize(m, used);
+
+        for(uint32_t id : deferred) {
+            cavity found;
+            uint32_t hint = static_cast<uint32_t>(m.size() - 1);
+
+            uint32_t existing = find_cavity(m, points[id], hint, found);
+            if(existing != none) {
+                result[id] = existing;
+                continue;
+            }
+
+            uint32_t first = static_cast<uint32_t>(m.size());
+            resize(m, m.size() + found.sides.size() - found.triangles.size());
+            fill_cavity(m, n + id, found, first);
+            result[id] = n + id;
+        }
+
+        // Drop the vertices of points that were already there
+        std::vector<uint32_t> renumbered(points.size(), none);
+        uint32_t next_vertex = n;
+
+        for(uint32_t id = 0; id < points.size(); ++id) {
+            if(result[id] == n + id) {
+                m.vertices[next_vertex] = points[id];
+                renumbered[id] = next_vertex++;
+            }
+        }
+
+        if(next_vertex < m.vertices.size()) {
+            auto remap = [&](uint32_t& v) {
+                if(v >= n) v = renumbered[v - n];
+            };
+
+            for(uint32_t& v : m.indices) remap(v);
+            for(uint32_t& v : m.hull) remap(v);
+
+            // Duplicates point at a vertex that may have moved too
+            for(uint32_t& v : result) remap(v);
+
+            m.vertices.resize(next_vertex);
+        }
+
+        return result;
+    }
+}
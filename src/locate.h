@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "geometry.h"
+#include "mesh.h"
+
+namespace delaunay {
+    /*
+    ** Queries against a Delaunay mesh, walking from triangle `hint`: any
+    ** triangle works, and the answer to a nearby query makes the walk short.
+    ** The queries only read the mesh, so any number of threads can run them
+    ** at once (see concurrent_mesh for a mesh that also changes).
+     */
+
+    // Triangle containing p, or none outside the hull
+    uint32_t locate(const mesh_view& m, const point& p, uint32_t hint = 0);
+
+    // Vertex closest to p, found by walking the Delaunay edges greedily; none
+    // for a mesh without triangles
+    uint32_t nearest_vertex(const mesh_view& m, const point& p, uint32_t hint = 0);
+
+    // Linear interpolation of per-vertex values at p, NaN outside the hull
+    double interpolate(const mesh_view& m, const std::vector<double>& values, const point& p,
+                       uint32_t hint = 0);
+
+    /*
+    ** Add p to a Delaunay mesh (Bowyer-Watson on the neighbor table) and
+    ** return its vertex index, or the index of the vertex already at p.
+    ** Points outside the hull are joined to the hull edges they see. The
+    ** triangles replaced are reused and new ones appended, so the last
+    ** triangle is a good hint for the next nearby point. Constraint flags are
+    ** kept on the edges that survive.
+     */
+    uint32_t insert(mesh& m, const point& p, uint32_t hint = 0);
+
+    /*
+    ** Insert a batch of points on `threads` threads (0 for every hardware
+    ** thread) and return the vertex of every point. Insertion runs in
+    ** rounds: each point in a window of pending points finds its cavity
+    ** without changing the mesh and claims the triangles it would change,
+    ** the point of highest priority (earliest in the batch) winning every
+    ** triangle. Points that won all their claims are inserted in parallel;
+    ** the others let go and retry in the next round. The result is the same
+    ** for any number of threads. Points on or outside the hull are inserted
+    ** one at a time at the end.
+     */
+    std::vector<uint32_t> insert(mesh& m, const std::vector<point>& points, unsigned threads = 0);
+}
@@ -0,0 +1,63 @@
+#include "mapped_file.h"
+
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+mapped_file::mapped_file(const std::string& path): address(nullptr), length(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0) throw std::runtime_error("unable to open " + path);
+
+    struct stat info;
+    if(fstat(fd, &info) != 0) {
+        close(fd);
+        throw std::runtime_error("unable to stat " + path);
+    }
+
+    length = static_cast<size_t>(info.st_size);
+
+    // mmap rejects empty mappings, but an empty file is still a valid file
+    if(length > 0) {
+        void* region = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(region == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("unable to map " + path);
+        }
+
+        address = static_cast<const char*>(region);
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+}
+
+mapped_file::~mapped_file() {
+    if(address) munmap(const_cast<char*>(address), length);
+}
+
+mapped_file::mapped_file(mapped_file&& other) noexcept:
+    address(std::exchange(other.address, nullptr)),
+    length(std::exchange(other.length, 0)) {}
+
+mapped_file& mapped_file::operator=(mapped_file&& other) noexcept {
+    if(this != &other) {
+        if(address) munmap(const_cast<char*>(address), length);
+
+        address = std::exchange(other.address, nullptr);
+        length = std::exchange(other.length, 0);
+    }
+
+    return *this;
+}
+
+const char* mapped_file::data() const {
+    return address;
+}
+
+size_t mapped_file::size() const {
+    return length;
+}
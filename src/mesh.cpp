@@ -0,0 +1,576 @@
+#include "mesh.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "parallel.h"
+
+namespace {
+    /*
+    ** On-disk layout, little-endian:
+    **   header
+    **   vertex_count   * point     (x, y as doubles)
+    **   triangle_count * 3 uint32  (indices)
+    **   triangle_count * 3 uint32  (neighbors)
+    **   hull_count     * uint32    (hull)
+    **   triangle_count * uint8     (constraints)
+    **
+    ** The header is 32 bytes, so every array is naturally aligned when the
+    ** file is mapped at a page boundary.
+     */
+    struct header {
+        char magic[4];
+        uint32_t version;
+        uint64_t vertex_count;
+        uint64_t triangle_count;
+        uint64_t hull_count;
+    };
+
+    const char magic[4] = {'D', 'L', 'N', 'Y'};
+
+    static_assert(sizeof(header) == 32, "unexpected header padding");
+    static_assert(sizeof(point) == 2 * sizeof(double), "unexpected point padding");
+
+    // The file is the in-memory layout, which only matches on little-endian hosts
+    void require_little_endian(const std::string& path) {
+        const uint32_t probe = 1;
+        uint8_t first;
+        std::memcpy(&first, &probe, 1);
+
+        if(first != 1) throw std::runtime_error(path + ": mesh files need a little-endian host");
+    }
+
+    uint32_t corner(const uint32_t* indices, uint32_t t, uint32_t v) {
+        for(uint32_t i = 0; i < 3; ++i) {
+            if(indices[3 * t + i] == v) return 3 * t + i;
+        }
+
+        return mesh::none;
+    }
+
+    uint32_t next_around(const uint32_t* indices, const uint32_t* neighbors, uint32_t slot) {
+        // The next triangle shares the edge arriving at the vertex
+        uint32_t next = neighbors[mesh::previous(slot)];
+        if(next == mesh::none) return mesh::none;
+
+        return corner(indices, next, indices[slot]);
+    }
+}
+
+mesh::mesh() {}
+
+mesh::mesh(std::vector<point> vertices, const std::vector<triangle>& triangles):
+    vertices(std::move(vertices)) {
+    // Triangles carry copies of the input points, so an exact lookup
+    // recovers their indices
+    std::vector<uint32_t> order(this->vertices.size());
+    for(uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+
+    auto less = [&](const point& a, const point& b) {
+        return a.x < b.x || (a.x == b.x && a.y < b.y);
+    };
+
+    // By y, then stably by x
+    std::vector<uint64_t> keys(order.size());
+    for(size_t i = 0; i < order.size(); ++i) keys[i] = delaunay::radix_key(this->vertices[i].y);
+    delaunay::radix_sort(keys, order);
+
+    for(size_t k = 0; k < order.size(); ++k) keys[k] = delaunay::radix_key(this->vertices[order[k]].x);
+    delaunay::radix_sort(keys, order);
+
+    auto find = [&](const point& p) {
+        auto it = std::lower_bound(order.begin(), order.end(), p,
+                                   [&](uint32_t i, const point& q) {
+                                       return less(this->vertices[i], q);
+                                   });
+
+        if(it == order.end() || !(this->vertices[*it].x == p.x && this->vertices[*it].y == p.y)) {
+            throw std::invalid_argument("triangle vertex is not in the vertex list");
+        }
+
+        return *it;
+    };
+
+    indices.reserve(triangles.size() * 3);
+    for(const triangle& t : triangles) {
+        uint32_t a = find(t.a), b = find(t.b), c = find(t.c);
+        if(!(point::orientation(t.a, t.b, t.c) > 0.0)) std::swap(b, c);
+
+        indices.push_back(a);
+        indices.push_back(b);
+        indices.push_back(c);
+    }
+
+    constraints.assign(triangles.size(), 0);
+    connect();
+    trace_hull();
+}
+
+size_t mesh::size() const {
+    return indices.size() / 3;
+}
+
+triangle mesh::at(size_t t) const {
+    return triangle(vertices[indices[3 * t]],
+                    vertices[indices[3 * t + 1]],
+                    vertices[indices[3 * t + 2]]);
+}
+
+std::vector<triangle> mesh::triangles() const {
+    std::vector<triangle> result;
+    result.reserve(size());
+
+    for(size_t t = 0; t < size(); ++t) result.push_back(at(t));
+
+    return result;
+}
+
+void mesh::connect() {
+    /* Every interior edge appears twice, once in each direction. Sorting the
+    ** half-edges by their undirected key places the two halves next to each
+    ** other, which avoids hashing entirely.
+     */
+    struct half_edge {
+        uint64_t key;
+        uint32_t slot;
+    };
+
+    std::vector<half_edge> edges;
+    edges.reserve(indices.size());
+
+    for(uint32_t slot = 0; slot < indices.size(); ++slot) {
+        uint64_t a = indices[slot];
+        uint64_t b = indices[next(slot)];
+        if(a > b) std::swap(a, b);
+
+        edges.push_back({a << 32 | b, slot});
+    }
+
+    std::sort(edges.begin(), edges.end(), [](const half_edge& a, const half_edge& b) {
+        return a.key < b.key;
+    });
+
+    neighbors.assign(indices.size(), none);
+    for(size_t i = 0; i + 1 < edges.size(); ++i) {
+        if(edges[i].key != edges[i + 1].key) continue;
+
+        neighbors[edges[i].slot] = edges[i + 1].slot / 3;
+        neighbors[edges[i + 1].slot] = edges[i].slot / 3;
+        ++i;
+    }
+}
+
+void mesh::trace_hull() {
+    /* In a counter-clockwise triangle, an edge without a neighbor runs
+    ** counter-clockwise around the hull, so each hull vertex has exactly one
+    ** successor. Anything else (no triangles, holes, pinched boundaries)
+    ** leaves the hull empty.
+     */
+    hull.clear();
+
+    std::vector<uint32_t> next(vertices.size(), none);
+    uint32_t first = none;
+    size_t count = 0;
+
+    for(size_t slot = 0; slot < indices.size(); ++slot) {
+        if(neighbors[slot] != none) continue;
+
+        uint32_t a = indices[slot];
+        uint32_t b = indices[mesh::next(slot)];
+        if(next[a] != none) return;
+
+        next[a] = b;
+        first = a;
+        ++count;
+    }
+
+    if(first == none) return;
+
+    uint32_t v = first;
+    do {
+        hull.push_back(v);
+        v = next[v];
+    } while(v != first && v != none && hull.size() <= count);
+
+    if(v != first || hull.size() != count) hull.clear();
+}
+
+std::vector<uint32_t> mesh::vertex_slots() const {
+    std::vector<uint32_t> slots(vertices.size(), none);
+
+    for(uint32_t slot = 0; slot < indices.size(); ++slot) {
+        uint32_t& first = slots[indices[slot]];
+
+        // The edge leaving the vertex has no neighbor only in the most
+        // clockwise triangle around a boundary vertex
+        if(first == none || neighbors[slot] == none) first = slot;
+    }
+
+    return slots;
+}
+
+uint32_t mesh::next(uint32_t slot) {
+    return slot - slot % 3 + (slot + 1) % 3;
+}
+
+uint32_t mesh::previous(uint32_t slot) {
+    return slot - slot % 3 + (slot + 2) % 3;
+}
+
+uint32_t mesh::corner(uint32_t t, uint32_t v) const {
+    return ::corner(indices.data(), t, v);
+}
+
+uint32_t mesh::next_around(uint32_t slot) const {
+    return ::next_around(indices.data(), neighbors.data(), slot);
+}
+
+namespace {
+    // For an inverted ear of m, the triangle across its third edge if that
+    // holds the tip of the ear, otherwise none
+    uint32_t ear_host(const mesh& m, uint32_t t) {
+        const uint32_t none = mesh::none;
+        const std::vector<point>& vertices = m.vertices;
+        const std::vector<uint32_t>& indices = m.indices;
+
+        const uint32_t* v = &m.indices[3 * t];
+        const uint32_t* n = &m.neighbors[3 * t];
+
+        for(uint32_t i = 0; i < 3; ++i) {
+            if(n[i] != none || n[(i + 1) % 3] != none || n[(i + 2) % 3] == none) continue;
+
+            uint32_t a = v[i], b = v[(i + 1) % 3], c = v[(i + 2) % 3];
+            if(point::orientation(vertices[a], vertices[b], vertices[c]) > 0.0) return none;
+
+            // The host shares the edge a -> c, opposite its vertex x
+            uint32_t host = n[(i + 2) % 3];
+            uint32_t j = m.corner(host, a);
+            if(j == none) return none;
+
+            uint32_t x = indices[mesh::previous(j)];
+
+            bool inside = point::orientation(vertices[a], vertices[c], vertices[b]) > 0.0 &&
+                          point::orientation(vertices[c], vertices[x], vertices[b]) > 0.0 &&
+                          point::orientation(vertices[x], vertices[a], vertices[b]) > 0.0;
+
+            return inside ? host : none;
+        }
+
+        return none;
+    }
+
+    // For an inverted triangle of m with one hull edge, whose opposite vertex
+    // is not on the hull, the slot of that edge; otherwise none
+    uint32_t crossed_edge(const mesh& m, uint32_t t) {
+        const uint32_t* n = &m.neighbors[3 * t];
+
+        uint32_t open = (n[0] == mesh::none) + (n[1] == mesh::none) + (n[2] == mesh::none);
+        if(open != 1) return mesh::none;
+
+        uint32_t i = n[0] == mesh::none ? 0 : n[1] == mesh::none ? 1 : 2;
+        uint32_t b = m.indices[3 * t + (i + 2) % 3];
+
+        if(point::orientation(m.vertices[m.indices[3 * t + i]], m.vertices[m.indices[3 * t + (i + 1) % 3]],
+                              m.vertices[b]) > 0.0) return mesh::none;
+        if(std::find(m.hull.begin(), m.hull.end(), b) != m.hull.end()) return mesh::none;
+
+        return 3 * t + i;
+    }
+}
+
+bool mesh::repairable(uint32_t t) const {
+    return ear_host(*this, t) != none || crossed_edge(*this, t) != none;
+}
+
+bool mesh::restore_delaunay(size_t max_flips) {
+    // Point the neighbor of triangle t across its edge at `from` to `to`
+    auto relink = [&](uint32_t t, uint32_t from, uint32_t to) {
+        if(t == none) return;
+
+        for(uint32_t k = 0; k < 3; ++k) {
+            if(neighbors[3 * t + k] == from) neighbors[3 * t + k] = to;
+        }
+    };
+
+    for(uint32_t t = 0; t < size();) {
+        if(point::orientation(vertices[indices[3 * t]], vertices[indices[3 * t + 1]],
+                              vertices[indices[3 * t + 2]]) > 0.0) {
+            ++t;
+            continue;
+        }
+
+        uint32_t crossed = crossed_edge(*this, t);
+        if(crossed != none) {
+            /* Drop the triangle (a, c, b) whose vertex b moved out across its
+            ** hull edge a -> c: its other two edges now bound the hull, with
+            ** b between a and c. The last triangle takes its place.
+             */
+            uint32_t a = indices[crossed], c = indices[3 * t + (crossed + 1) % 3];
+            uint32_t b = indices[3 * t + (crossed + 2) % 3];
+
+            for(uint32_t k = 0; k < 3; ++k) relink(neighbors[3 * t + k], t, none);
+
+            uint32_t last = static_cast<uint32_t>(size()) - 1;
+            if(last != t) {
+                for(uint32_t k = 0; k < 3; ++k) {
+                    indices[3 * t + k] = indices[3 * last + k];
+                    neighbors[3 * t + k] = neighbors[3 * last + k];
+                    relink(neighbors[3 * t + k], last, t);
+                }
+
+                constraints[t] = constraints[last];
+            }
+
+            indices.resize(3 * last);
+            neighbors.resize(3 * last);
+            constraints.resize(last);
+
+            auto at = std::find(hull.begin(), hull.end(), a);
+            if(at != hull.end() && hull[(at - hull.begin() + 1) % hull.size()] == c) hull.insert(at + 1, b);
+
+            continue;
+        }
+
+        uint32_t host = ear_host(*this, t);
+        if(host == none) return false;
+
+        /* Fold the ear (a, b, c) into its host (a, c, x), which now holds b:
+        ** the ear becomes (a, c, b) on the hull, the host (c, x, b) and a new
+        ** triangle (x, a, b) completes the split.
+         */
+        uint32_t i = 0;
+        while(neighbors[3 * t + (i + 2) % 3] != host) ++i;
+
+        uint32_t a = indices[3 * t + i], b = indices[3 * t + (i + 1) % 3], c = indices[3 * t + (i + 2) % 3];
+
+        uint32_t j = corner(host, a);
+
+        uint32_t x = indices[previous(j)];
+        uint32_t cx = neighbors[next(j)], xa = neighbors[previous(j)];
+
+        uint32_t split = static_cast<uint32_t>(size());
+
+        const uint32_t ear[3] = { a, c, b }, rest[3] = { c, x, b };
+        const uint32_t ear_neighbors[3] = { none, host, split }, rest_neighbors[3] = { cx, split, t };
+
+        for(uint32_t k = 0; k < 3; ++k) {
+            indices[3 * t + k] = ear[k];
+            indices[3 * host + k] = rest[k];
+            neighbors[3 * t + k] = ear_neighbors[k];
+            neighbors[3 * host + k] = rest_neighbors[k];
+        }
+
+        indices.insert(indices.end(), { x, a, b });
+        neighbors.insert(neighbors.end(), { xa, t, host });
+        constraints.push_back(0);
+
+        relink(xa, host, split);
+
+        hull.erase(std::remove(hull.begin(), hull.end(), b), hull.end());
+        ++t;
+    }
+
+    /* A vertex that moved inwards dents the hull. The dent is filled with
+    ** the triangle across it, which takes the vertex off the hull and may
+    ** expose a dent at its neighbors, so this repeats until none is left.
+     */
+    std::vector<uint32_t> leaving(vertices.size(), none);
+    for(uint32_t slot = 0; slot < indices.size(); ++slot) {
+        if(neighbors[slot] == none) leaving[indices[slot]] = slot;
+    }
+
+    for(bool filled = true; filled;) {
+        filled = false;
+
+        for(size_t i = 0; i < hull.size() && hull.size() > 3;) {
+            uint32_t a = hull[(i + hull.size() - 1) % hull.size()];
+            uint32_t b = hull[i];
+            uint32_t c = hull[(i + 1) % hull.size()];
+
+            if(!(point::orientation(vertices[c], vertices[b], vertices[a]) > 0.0)) {
+                ++i;
+                continue;
+            }
+
+            // The new triangle (a, c, b) lies across the hull edges a -> b and b -> c
+            uint32_t t = static_cast<uint32_t>(size());
+            indices.insert(indices.end(), { a, c, b });
+            neighbors.insert(neighbors.end(), { none, leaving[b] / 3, leaving[a] / 3 });
+            constraints.push_back(0);
+
+            neighbors[leaving[b]] = t;
+            neighbors[leaving[a]] = t;
+            leaving[a] = 3 * t;
+
+            hull.erase(hull.begin() + i);
+            filled = true;
+        }
+    }
+
+    std::vector<uint32_t> pending(indices.size());
+    for(uint32_t slot = 0; slot < pending.size(); ++slot) pending[slot] = slot;
+
+    size_t flips = 0;
+    while(!pending.empty()) {
+        uint32_t slot = pending.back();
+        pending.pop_back();
+
+        /* Triangle t = (a, b, c) across its edge a -> b from u = (b, a, d).
+        ** If d lies in the circumcircle of t, the edge becomes c -> d:
+        ** t = (a, d, c) and u = (d, b, c).
+         */
+        uint32_t t = slot / 3;
+        uint32_t u = neighbors[slot];
+        if(u == none) continue;
+
+        uint32_t a = indices[slot], b = indices[next(slot)], c = indices[previous(slot)];
+
+        uint32_t j = corner(u, b);
+        if(j == none || indices[next(j)] != a) continue;
+
+        uint32_t d = indices[previous(j)];
+
+        triangle abc(vertices[a], vertices[b], vertices[c]);
+        if(!abc.circumcircle().contains(vertices[d])) continue;
+
+        if(++flips > max_flips) return false;
+
+        uint32_t bc = neighbors[next(slot)], ca = neighbors[previous(slot)];
+        uint32_t ad = neighbors[next(j)], db = neighbors[previous(j)];
+
+        const uint32_t first[3] = { a, d, c }, second[3] = { d, b, c };
+        const uint32_t first_neighbors[3] = { ad, u, ca }, second_neighbors[3] = { db, bc, t };
+
+        for(uint32_t k = 0; k < 3; ++k) {
+            indices[3 * t + k] = first[k];
+            indices[3 * u + k] = second[k];
+            neighbors[3 * t + k] = first_neighbors[k];
+            neighbors[3 * u + k] = second_neighbors[k];
+        }
+
+        relink(ad, u, t);
+        relink(bc, t, u);
+
+        // The outer edges of the quadrilateral may no longer be Delaunay
+        pending.insert(pending.end(), { 3 * t, 3 * t + 2, 3 * u, 3 * u + 1 });
+    }
+
+    return true;
+}
+
+void mesh::save(const std::string& path) const {
+    require_little_endian(path);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if(!out) throw std::runtime_error("unable to open " + path);
+
+    header h;
+    std::memcpy(h.magic, magic, sizeof(magic));
+    h.version = mapped_mesh::version;
+    h.vertex_count = vertices.size();
+    h.triangle_count = size();
+    h.hull_count = hull.size();
+
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    out.write(reinterpret_cast<const char*>(vertices.data()), vertices.size() * sizeof(point));
+    out.write(reinterpret_cast<const char*>(indices.data()), indices.size() * sizeof(uint32_t));
+    out.write(reinterpret_cast<const char*>(neighbors.data()), neighbors.size() * sizeof(uint32_t));
+    out.write(reinterpret_cast<const char*>(hull.data()), hull.size() * sizeof(uint32_t));
+    out.write(reinterpret_cast<const char*>(constraints.data()), constraints.size());
+
+    if(!out) throw std::runtime_error("unable to write " + path);
+}
+
+mesh_view::mesh_view():
+    vertices(nullptr), vertex_count(0),
+    indices(nullptr), neighbors(nullptr), constraints(nullptr),
+    triangle_count(0), hull(nullptr), hull_count(0) {}
+
+mesh_view::mesh_view(const mesh& m):
+    vertices(m.vertices.data()), vertex_count(m.vertices.size()),
+    indices(m.indices.data()), neighbors(m.neighbors.data()),
+    constraints(m.constraints.data()), triangle_count(m.size()),
+    hull(m.hull.data()), hull_count(m.hull.size()) {}
+
+size_t mesh_view::size() const {
+    return triangle_count;
+}
+
+triangle mesh_view::at(size_t t) const {
+    return triangle(vertices[indices[3 * t]],
+                    vertices[indices[3 * t + 1]],
+                    vertices[indices[3 * t + 2]]);
+}
+
+uint32_t mesh_view::corner(uint32_t t, uint32_t v) const {
+    return ::corner(indices, t, v);
+}
+
+uint32_t mesh_view::next_around(uint32_t slot) const {
+    return ::next_around(indices, neighbors, slot);
+}
+
+mapped_mesh::mapped_mesh(const std::string& path): file(path) {
+    require_little_endian(path);
+
+    if(file.size() < sizeof(header)) {
+        throw std::runtime_error(path + " is not a mesh file");
+    }
+
+    header h;
+    std::memcpy(&h, file.data(), sizeof(header));
+
+    if(std::memcmp(h.magic, magic, sizeof(magic)) != 0) {
+        throw std::runtime_error(path + " is not a mesh file");
+    }
+
+    if(h.version != version) {
+        throw std::runtime_error(path + " has unsupported mesh version " +
+                                 std::to_string(h.version));
+    }
+
+    // Counts come from the file, so each is checked by division against
+    // what is left rather than summed into a size that could wrap
+    size_t left = file.size() - sizeof(header);
+    auto take = [&](uint64_t count, size_t record) {
+        if(count > left / record) throw std::runtime_error(path + " is truncated");
+        left -= static_cast<size_t>(count) * record;
+    };
+
+    take(h.vertex_count, sizeof(point));
+    take(h.triangle_count, 6 * sizeof(uint32_t) + 1);
+    take(h.hull_count, sizeof(uint32_t));
+
+    if(h.triangle_count >= mesh::none) throw std::runtime_error(path + " has too many triangles");
+
+    const char* data = file.data() + sizeof(header);
+
+    vertices = reinterpret_cast<const point*>(data);
+    vertex_count = h.vertex_count;
+    data += h.vertex_count * sizeof(point);
+
+    indices = reinterpret_cast<const uint32_t*>(data);
+    data += h.triangle_count * 3 * sizeof(uint32_t);
+
+    neighbors = reinterpret_cast<const uint32_t*>(data);
+    data += h.triangle_count * 3 * sizeof(uint32_t);
+
+    hull = reinterpret_cast<const uint32_t*>(data);
+    hull_count = h.hull_count;
+    data += h.hull_count * sizeof(uint32_t);
+
+    constraints = reinterpret_cast<const uint8_t*>(data);
+    triangle_count = h.triangle_count;
+
+    bool valid = true;
+    for(size_t i = 0; i < 3 * triangle_count; ++i) {
+        valid &= indices[i] < vertex_count;
+        valid &= neighbors[i] < triangle_count || neighbors[i] == mesh::none;
+    }
+
+    for(size_t i = 0; i < hull_count; ++i) valid &= hull[i] < vertex_count;
+
+    if(!valid) throw std::runtime_error(path + " has indices out of range");
+}
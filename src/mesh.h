@@ -0,0 +1,126 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "geometry.h"
+#include "mapped_file.h"
+
+/*
+** Indexed triangulation: every triangle refers to its vertices by index and
+** knows the triangle across each of its edges. The arrays are laid out exactly
+** as they are stored on disk, so a saved mesh can be mapped back and used
+** without any parsing.
+*/
+class mesh {
+public:
+    // Marks an edge without a neighbor, i.e. an edge on the convex hull
+    static constexpr uint32_t none = UINT32_MAX;
+
+    std::vector<point> vertices;
+
+    // Three vertex indices per triangle, in counter-clockwise order
+    std::vector<uint32_t> indices;
+
+    // neighbors[3 * t + i] is the triangle across the edge from
+    // vertex i to vertex (i + 1) % 3 of triangle t
+    std::vector<uint32_t> neighbors;
+
+    // One byte per triangle; bit i marks the edge from vertex i to vertex
+    // (i + 1) % 3 (same numbering as neighbors) as constrained
+    std::vector<uint8_t> constraints;
+
+    // Convex hull as a counter-clockwise ring of vertex indices
+    std::vector<uint32_t> hull;
+
+    mesh();
+
+    // Index the triangles against the given vertices
+    mesh(std::vector<point> vertices, const std::vector<triangle>& triangles);
+
+    size_t size() const;
+    triangle at(size_t t) const;
+    std::vector<triangle> triangles() const;
+
+    // Rebuild the neighbor table from the indices
+    void connect();
+
+    // Rebuild the hull ring by chaining the edges without a neighbor
+    void trace_hull();
+
+    /* Walking the triangles around a vertex: slot 3 * t + i names corner i
+    ** of triangle t. next() and previous() step to the following and the
+    ** preceding corner of the same triangle, and corner() gives the slot of
+    ** vertex v in triangle t, or none. vertex_slots() gives one slot of
+    ** every vertex (none for vertices no triangle uses), the most clockwise
+    ** one around boundary vertices, and next_around() steps to the same
+    ** vertex in the next triangle counter-clockwise, or none past the
+    ** boundary.
+     */
+    static uint32_t next(uint32_t slot);
+    static uint32_t previous(uint32_t slot);
+    uint32_t corner(uint32_t t, uint32_t v) const;
+    std::vector<uint32_t> vertex_slots() const;
+    uint32_t next_around(uint32_t slot) const;
+
+    /* Flip edges until every edge is locally Delaunay (Lawson), e.g. after
+    ** moving vertices. The hull is repaired first where vertices crossed it
+    ** (see repairable) and dents in it are filled with new triangles.
+    ** Returns false when any other triangle is inverted, which flips cannot
+    ** repair, or when more than `max_flips` flips are needed. The mesh may
+    ** then still hold inverted triangles and must be rebuilt from its
+    ** vertices (triangulate_mesh), as relax() does.
+     */
+    bool restore_delaunay(size_t max_flips = SIZE_MAX);
+
+    /* Whether restore_delaunay() can repair inverted triangle t: an ear
+    ** (two hull edges) whose tip moved into the triangle across its third
+    ** edge is folded into it, and a triangle whose vertex moved out across
+    ** its hull edge is dropped, so that the vertex joins the hull.
+     */
+    bool repairable(uint32_t t) const;
+
+    void save(const std::string& path) const;
+};
+
+// Non-owning view of a mesh, shared by in-memory and mapped meshes
+class mesh_view {
+public:
+    const point* vertices;
+    size_t vertex_count;
+
+    const uint32_t* indices;
+    const uint32_t* neighbors;
+    const uint8_t* constraints;
+    size_t triangle_count;
+
+    const uint32_t* hull;
+    size_t hull_count;
+
+    mesh_view();
+    mesh_view(const mesh& m);
+
+    size_t size() const;
+    triangle at(size_t t) const;
+
+    // As on mesh
+    uint32_t corner(uint32_t t, uint32_t v) const;
+    uint32_t next_around(uint32_t slot) const;
+};
+
+/*
+** A mesh saved with mesh::save, mapped read-only into memory. The counts
+** are checked against the file size and every index, neighbor and hull
+** entry against its range, so a truncated or crafted file is rejected
+** rather than read out of bounds. Files are little-endian; other hosts
+** can neither save nor map them.
+ */
+class mapped_mesh : public mesh_view {
+public:
+    static constexpr uint32_t version = 2;
+
+    explicit mapped_mesh(const std::string& path);
+
+private:
+    mapped_file file;
+};
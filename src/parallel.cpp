@@ -0,0 +1,312 @@
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace delaunay {
+    namespace {
+        // Threads kept for parallel loops, started as loops ask for them
+        class thread_pool {
+        public:
+            ~thread_pool() {
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    stopping = true;
+                }
+
+                ready.notify_all();
+                for(std::thread& t : workers) t.join();
+            }
+
+            void submit(std::function<void()> task, size_t wanted) {
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    while(workers.size() < wanted) workers.emplace_back([this]() { work(); });
+                    tasks.push_back(std::move(task));
+                }
+
+                ready.notify_one();
+            }
+
+        private:
+            std::mutex lock;
+            std::condition_variable ready;
+            std::deque<std::function<void()>> tasks;
+            std::vector<std::thread> workers;
+            bool stopping = false;
+
+            void work() {
+                for(;;) {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> guard(lock);
+                        ready.wait(guard, [this]() { return stopping || !tasks.empty(); });
+                        if(tasks.empty()) return;
+
+                        task = std::move(tasks.front());
+                        tasks.pop_front();
+                    }
+
+                    task();
+                }
+            }
+        };
+
+        thread_pool& shared_pool() {
+            static thread_pool pool;
+            return pool;
+        }
+
+        std::mutex executor_lock;
+        executor custom;
+
+        /* Indices left to one thread, on a cache line of its own. The bounds
+        ** change under the lock but are atomic so thieves can size up every
+        ** range without taking its lock.
+         */
+        class alignas(64) range {
+        public:
+            std::mutex lock;
+            std::atomic<size_t> begin{0}, end{0};
+
+            size_t left() const {
+                size_t first = begin.load(std::memory_order_relaxed), last = end.load(std::memory_order_relaxed);
+                return last > first ? last - first : 0;
+            }
+        };
+
+        /* State of one loop, shared with its tasks so that tasks starting
+        ** late find the loop over instead of a dangling stack frame.
+         */
+        class loop {
+        public:
+            loop(size_t count, unsigned threads, const std::function<void(size_t)>& body):
+                ranges(new range[threads]), threads(threads), body(&body) {
+                for(unsigned t = 0; t < threads; ++t) {
+                    ranges[t].begin = count * t / threads;
+                    ranges[t].end = count * (t + 1) / threads;
+                }
+            }
+
+            std::unique_ptr<range[]> ranges;
+            unsigned threads;
+            const std::function<void(size_t)>* body;
+
+            std::atomic<unsigned> joined{1};
+            std::atomic<bool> failed{false};
+
+            std::mutex lock;
+            std::condition_variable finished;
+            unsigned active = 0;
+            std::exception_ptr error;
+
+            // Next index of range t, taking half of the largest other range
+            // once it is empty
+            bool next(unsigned t, size_t& i) {
+                range& own = ranges[t];
+
+                for(;;) {
+                    if(failed) return false;
+
+                    {
+                        std::lock_guard<std::mutex> guard(own.lock);
+                        if(own.left()) {
+                            i = own.begin++;
+                            return true;
+                        }
+                    }
+
+                    // Sizes are read unlocked; the victim is checked again below
+                    unsigned victim = t;
+                    size_t largest = 0;
+
+                    for(unsigned v = 0; v < threads; ++v) {
+                        if(v != t && ranges[v].left() > largest) {
+                            largest = ranges[v].left();
+                            victim = v;
+                        }
+                    }
+
+                    if(victim == t) return false;
+
+                    // The back half, rounded up so a last index can be taken too
+                    size_t begin, end;
+                    {
+                        range& other = ranges[victim];
+                        std::lock_guard<std::mutex> guard(other.lock);
+                        if(!other.left()) continue;
+
+                        end = other.end;
+                        begin = other.begin + (end - other.begin) / 2;
+                        other.end = begin;
+                    }
+
+                    std::lock_guard<std::mutex> guard(own.lock);
+                    own.begin = begin;
+                    own.end = end;
+                }
+            }
+
+            void run(unsigned t) {
+                size_t i;
+                while(next(t, i)) {
+                    try {
+                        (*body)(i);
+                    } catch(...) {
+                        std::lock_guard<std::mutex> guard(lock);
+                        if(!error) error = std::current_exception();
+
+                        // Stop handing out work once anything has failed
+                        failed = true;
+                    }
+                }
+            }
+
+            void help() {
+                unsigned t = joined++;
+                if(t >= threads) return;
+
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    ++active;
+                }
+
+                run(t);
+
+                std::lock_guard<std::mutex> guard(lock);
+                if(--active == 0) finished.notify_all();
+            }
+        };
+    }
+
+    void parallel_for(size_t count, unsigned threads, const std::function<void(size_t)>& body) {
+        if(threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        threads = static_cast<unsigned>(std::min<size_t>(threads, count));
+
+        if(threads <= 1) {
+            for(size_t i = 0; i < count; ++i) body(i);
+            return;
+        }
+
+        executor run;
+        {
+            std::lock_guard<std::mutex> guard(executor_lock);
+            run = custom;
+        }
+
+        std::shared_ptr<loop> state = std::make_shared<loop>(count, threads, body);
+
+        for(unsigned t = 1; t < threads; ++t) {
+            std::function<void()> task = [state]() { state->help(); };
+
+            if(run) {
+                run(std::move(task));
+            } else {
+                shared_pool().submit(std::move(task), threads - 1);
+            }
+        }
+
+        state->run(0);
+
+        // Wait for threads still working on a stolen range
+        std::unique_lock<std::mutex> guard(state->lock);
+        state->finished.wait(guard, [&]() { return state->active == 0; });
+
+        if(state->error) std::rethrow_exception(state->error);
+    }
+
+    void radix_sort(std::vector<uint64_t>& keys, std::vector<uint32_t>& values, unsigned threads) {
+        if(keys.size() != values.size()) throw std::invalid_argument("expected one value per key");
+
+        // Smallest part worth a thread of its own
+        const size_t grain = 1 << 14;
+        // Eleven bits a digit: six passes cover a key, three a 32-bit one
+        const unsigned bits = 11;
+        const size_t digits = (64 + bits - 1) / bits, buckets = size_t(1) << bits, mask = buckets - 1;
+
+        size_t count = keys.size();
+        if(threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+        size_t parts = std::max<size_t>(1, std::min<size_t>(threads, count / grain));
+        auto bound = [&](size_t part) { return count * part / parts; };
+
+        // Every digit's buckets over all keys, to skip digits the keys share
+        std::vector<size_t> histograms(parts * digits * buckets, 0);
+        parallel_for(parts, threads, [&](size_t part) {
+            size_t* histogram = &histograms[part * digits * buckets];
+            const uint64_t* from_keys = keys.data();
+
+            for(size_t i = bound(part), last = bound(part + 1); i < last; ++i) {
+                uint64_t key = from_keys[i];
+                for(size_t d = 0; d < digits; ++d) ++histogram[d * buckets + (key >> (bits * d) & mask)];
+            }
+        });
+
+        std::vector<uint64_t> key_buffer(count);
+        std::vector<uint32_t> value_buffer(count);
+        std::vector<size_t> offsets(parts * buckets);
+
+        for(size_t d = 0; d < digits; ++d) {
+            size_t largest = 0;
+            for(size_t b = 0; b < buckets; ++b) {
+                size_t total = 0;
+                for(size_t part = 0; part < parts; ++part) total += histograms[(part * digits + d) * buckets + b];
+                largest = std::max(largest, total);
+            }
+
+            if(largest == count) continue;
+
+            const unsigned shift = static_cast<unsigned>(bits * d);
+
+            // Raw pointers, as the stores would otherwise reload the vectors
+            const uint64_t* from_keys = keys.data();
+            const uint32_t* from_values = values.data();
+            uint64_t* to_keys = key_buffer.data();
+            uint32_t* to_values = value_buffer.data();
+
+            // The parts hold other keys after every pass, so count them again
+            parallel_for(parts, threads, [&](size_t part) {
+                size_t* offset = &offsets[part * buckets];
+                std::fill(offset, offset + buckets, 0);
+                for(size_t i = bound(part); i < bound(part + 1); ++i) ++offset[from_keys[i] >> shift & mask];
+            });
+
+            // Bucket by bucket, each part writes after the parts before it
+            size_t next = 0;
+            for(size_t b = 0; b < buckets; ++b) {
+                for(size_t part = 0; part < parts; ++part) {
+                    size_t size = offsets[part * buckets + b];
+                    offsets[part * buckets + b] = next;
+                    next += size;
+                }
+            }
+
+            parallel_for(parts, threads, [&](size_t part) {
+                size_t* offset = &offsets[part * buckets];
+
+                for(size_t i = bound(part), last = bound(part + 1); i < last; ++i) {
+                    uint64_t key = from_keys[i];
+                    size_t slot = offset[key >> shift & mask]++;
+                    to_keys[slot] = key;
+                    to_values[slot] = from_values[i];
+                }
+            });
+
+            keys.swap(key_buffer);
+            values.swap(value_buffer);
+        }
+    }
+
+    void set_executor(executor run) {
+        std::lock_guard<std::mutex> guard(executor_lock);
+        custom = std::move(run);
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace delaunay {
+    /*
+    ** Run body(i) for every i in [0, count) on up to `threads` threads (0
+    ** uses every hardware thread), the calling thread included. Every
+    ** thread starts on its own contiguous range of indices and, once done,
+    ** steals the back half of the largest range left, so clustered work
+    ** still finishes on every thread at once.
+     */
+    void parallel_for(size_t count, unsigned threads, const std::function<void(size_t)>& body);
+
+    /*
+    ** Sort `values` by `keys`, both reordered, with a least significant
+    ** digit first radix sort: one pass per 11-bit digit of the keys,
+    ** skipping digits that all keys share, each pass counting and
+    ** scattering in parallel.
+    ** Stable, so sorting by a secondary key first and then by the primary
+    ** one orders by both.
+     */
+    void radix_sort(std::vector<uint64_t>& keys, std::vector<uint32_t>& values, unsigned threads = 0);
+
+    // Radix sort key in the order of the doubles, -0 and 0 alike (NaN excluded)
+    inline uint64_t radix_key(double value) {
+        if(value == 0.0) value = 0.0;
+
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        // Negative numbers count down from the sign bit, positive ones up past it
+        return bits >> 63 ? ~bits : bits | uint64_t(1) << 63;
+    }
+
+    /*
+    ** Runs a task on some thread of the caller's pool. parallel_for submits
+    ** one task per extra thread and also works on the calling thread, which
+    ** finishes the loop alone if no task starts; a task that starts after
+    ** the loop is over returns at once, so a busy pool never deadlocks.
+     */
+    using executor = std::function<void(std::function<void()> task)>;
+
+    // Run the tasks of every parallel loop on `run` instead of the library's
+    // own threads; an empty executor restores them
+    void set_executor(executor run);
+
+    // Sort [begin, end) by sorting one run per thread, then merging pairs of
+    // runs in parallel rounds. Not stable.
+    template<typename iterator, typename compare>
+    void parallel_sort(iterator begin, iterator end, compare less, unsigned threads = 0) {
+        // Smallest run worth a thread of its own
+        const size_t grain = 1 << 14;
+
+        size_t count = end - begin;
+        if(threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+        size_t runs = std::max<size_t>(1, std::min<size_t>(threads, count / grain));
+        auto bound = [&](size_t run) { return begin + count * run / runs; };
+
+        parallel_for(runs, threads, [&](size_t run) {
+            std::sort(bound(run), bound(run + 1), less);
+        });
+
+        for(size_t width = 1; width < runs; width *= 2) {
+            parallel_for((runs + 2 * width - 1) / (2 * width), threads, [&](size_t pair) {
+                size_t first = 2 * width * pair;
+                size_t middle = std::min(first + width, runs), last = std::min(first + 2 * width, runs);
+
+                if(middle < last) std::inplace_merge(bound(first), bound(middle), bound(last), less);
+            });
+        }
+    }
+}
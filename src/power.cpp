@@ -0,0 +1,148 @@
+#include "power.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "parallel.h"
+#include "trace.h"
+
+namespace delaunay {
+    namespace {
+        // Vertices per unit of parallel work
+        const size_t chunk = 4096;
+
+        // Sutherland-Hodgman against one side of the box: keep the points
+        // where side(p) >= 0, given side is linear along every edge
+        template<typename side_of>
+        void clip(const std::vector<point>& polygon, std::vector<point>& result, side_of side) {
+            result.clear();
+
+            for(size_t i = 0; i < polygon.size(); ++i) {
+                const point& p = polygon[i];
+                const point& q = polygon[(i + 1) % polygon.size()];
+
+                double sp = side(p), sq = side(q);
+                if(sp >= 0.0) result.push_back(p);
+
+                if((sp >= 0.0) != (sq >= 0.0)) {
+                    double t = sp / (sp - sq);
+                    result.emplace_back(p.x + t * (q.x - p.x), p.y + t * (q.y - p.y));
+                }
+            }
+        }
+
+        point outward(const point& from, const point& to) {
+            double dx = to.x - from.x, dy = to.y - from.y;
+            double length = std::sqrt(dx * dx + dy * dy);
+
+            return point(dy / length, -dx / length);
+        }
+    }
+
+    size_t power_diagram::size() const {
+        return offsets.empty() ? 0 : offsets.size() - 1;
+    }
+
+    std::vector<point> power_diagram::cell(size_t v) const {
+        return std::vector<point>(vertices.begin() + offsets[v], vertices.begin() + offsets[v + 1]);
+    }
+
+    power_diagram power_cells(const mesh& m, const std::vector<double>& weights,
+                              const point& min, const point& max, unsigned threads) {
+        if(!weights.empty() && weights.size() != m.vertices.size()) {
+            throw std::invalid_argument("expected one weight per vertex");
+        }
+
+        trace_span span("power cells");
+
+        auto weight = [&](uint32_t v) {
+            return weights.empty() ? 0.0 : weights[v];
+        };
+
+        // Dual vertex of every triangle
+        std::vector<point> centers(m.size());
+        for(size_t t = 0; t < m.size(); ++t) {
+            const uint32_t* v = &m.indices[3 * t];
+            centers[t] = m.at(t).power_circle(weight(v[0]), weight(v[1]), weight(v[2])).center;
+        }
+
+        std::vector<uint32_t> slots = m.vertex_slots();
+
+        point middle((min.x + max.x) / 2.0, (min.y + max.y) / 2.0);
+        double diagonal = std::sqrt(min.distance_squared(max));
+
+        size_t count = m.vertices.size();
+        std::vector<std::vector<uint32_t>> sizes((count + chunk - 1) / chunk);
+        std::vector<std::vector<point>> parts(sizes.size());
+
+        parallel_for(parts.size(), threads, [&](size_t part) {
+            std::vector<point> polygon, clipped;
+
+            for(size_t v = part * chunk; v < std::min(count, (part + 1) * chunk); ++v) {
+                polygon.clear();
+
+                uint32_t slot = slots[v], last = slots[v];
+                for(size_t steps = 0; slot != mesh::none && steps < m.size(); ++steps) {
+                    polygon.push_back(centers[slot / 3]);
+                    last = slot;
+
+                    slot = m.next_around(slot);
+                    if(slot == slots[v]) break;
+                }
+
+                if(slot == mesh::none && !polygon.empty()) {
+                    /* A hull vertex: its cell is unbounded between the outward
+                    ** normals of its two hull edges. Close it far enough out
+                    ** that the box lies inside, passing through the bisector
+                    ** of the normals so the closing chain turns by at most a
+                    ** right angle at a time.
+                     */
+                    const point& p = m.vertices[v];
+                    const point& next = m.vertices[m.indices[mesh::next(slots[v])]];
+                    const point& previous = m.vertices[m.indices[mesh::previous(last)]];
+
+                    point first_normal = outward(p, next);
+                    point last_normal = outward(previous, p);
+
+                    point bisector(first_normal.x + last_normal.x, first_normal.y + last_normal.y);
+                    double length = std::sqrt(bisector.x * bisector.x + bisector.y * bisector.y);
+                    if(length > 0.0) bisector = point(bisector.x / length, bisector.y / length);
+
+                    point first_center = polygon.front();
+                    point last_center = polygon.back();
+                    point between = point::midpoint(first_center, last_center);
+
+                    double reach = 4.0 * (diagonal + std::sqrt(std::max(
+                        middle.distance_squared(first_center), middle.distance_squared(last_center))));
+
+                    polygon.emplace_back(last_center.x + reach * last_normal.x, last_center.y + reach * last_normal.y);
+                    polygon.emplace_back(between.x + reach * bisector.x, between.y + reach * bisector.y);
+                    polygon.emplace_back(first_center.x + reach * first_normal.x, first_center.y + reach * first_normal.y);
+                }
+
+                clip(polygon, clipped, [&](const point& q) { return q.x - min.x; });
+                clip(clipped, polygon, [&](const point& q) { return max.x - q.x; });
+                clip(polygon, clipped, [&](const point& q) { return q.y - min.y; });
+                clip(clipped, polygon, [&](const point& q) { return max.y - q.y; });
+
+                // Only a proper polygon is a cell
+                if(polygon.size() < 3) polygon.clear();
+
+                sizes[part].push_back(static_cast<uint32_t>(polygon.size()));
+                parts[part].insert(parts[part].end(), polygon.begin(), polygon.end());
+            }
+        });
+
+        power_diagram diagram;
+        diagram.offsets.reserve(count + 1);
+        diagram.offsets.push_back(0);
+
+        for(size_t part = 0; part < parts.size(); ++part) {
+            for(uint32_t size : sizes[part]) diagram.offsets.push_back(diagram.offsets.back() + size);
+            diagram.vertices.insert(diagram.vertices.end(), parts[part].begin(), parts[part].end());
+        }
+
+        return diagram;
+    }
+}
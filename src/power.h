@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "geometry.h"
+#include "mesh.h"
+
+namespace delaunay {
+    /*
+    ** Power (Laguerre) cells, one counter-clockwise polygon per vertex of a
+    ** triangulation, stored back to back: the cell of vertex v is
+    ** vertices[offsets[v]] up to vertices[offsets[v + 1]]. Hidden vertices
+    ** and cells outside the clipping box are empty.
+     */
+    class power_diagram {
+    public:
+        std::vector<uint32_t> offsets;
+        std::vector<point> vertices;
+
+        size_t size() const;
+        std::vector<point> cell(size_t v) const;
+    };
+
+    /*
+    ** Cells of a regular triangulation (see triangulate_regular), as its
+    ** dual: every cell is read off the power circle centers of the triangles
+    ** around its vertex, with the unbounded cells of hull vertices closed by
+    ** rays, and then clipped to the box from `min` to `max`. Empty weights
+    ** give the Voronoi diagram of a Delaunay triangulation.
+     */
+    power_diagram power_cells(const mesh& m, const std::vector<double>& weights,
+                              const point& min, const point& max, unsigned threads = 0);
+}
@@ -0,0 +1,104 @@
+#include "raster.h"
+
+#include <cmath>
+#include <utility>
+#include <stdexcept>
+
+#include "trace.h"
+
+namespace delaunay {
+    raster::raster(size_t columns, size_t rows, double origin_x, double origin_y,
+                   double spacing_x, double spacing_y):
+        columns(columns), rows(rows), origin_x(origin_x), origin_y(origin_y),
+        spacing_x(spacing_x), spacing_y(spacing_y) {}
+
+    size_t raster::size() const {
+        return columns * rows;
+    }
+
+    point raster::at(size_t column, size_t row) const {
+        return point(origin_x + column * spacing_x, origin_y + row * spacing_y);
+    }
+
+    std::vector<uint8_t> raster_mask(const std::vector<double>& heights, double nodata) {
+        std::vector<uint8_t> mask(heights.size());
+        for(size_t i = 0; i < heights.size(); ++i) {
+            mask[i] = heights[i] != nodata && !std::isnan(heights[i]);
+        }
+
+        return mask;
+    }
+
+    void triangulate_raster(const raster& grid, const std::vector<uint8_t>& mask,
+                            std::vector<uint32_t>& indices) {
+        if(!mask.empty() && mask.size() != grid.size()) {
+            throw std::invalid_argument("raster mask does not match the grid size");
+        }
+
+        if(grid.size() > UINT32_MAX) throw std::length_error("too many raster nodes");
+
+        trace_span span("triangulate raster");
+
+        const uint32_t absent = UINT32_MAX;
+
+        // Vertex of every node, or absent
+        std::vector<uint32_t> vertex(grid.size(), absent);
+        uint32_t count = 0;
+        for(size_t i = 0; i < vertex.size(); ++i) {
+            if(mask.empty() || mask[i]) vertex[i] = count++;
+        }
+
+        indices.clear();
+        if(grid.columns < 2 || grid.rows < 2) return;
+
+        indices.reserve(6 * (grid.columns - 1) * (grid.rows - 1));
+
+        // Rows run downwards or columns leftwards when exactly one spacing is negative
+        bool mirrored = (grid.spacing_x < 0.0) != (grid.spacing_y < 0.0);
+
+        auto emit = [&](uint32_t a, uint32_t b, uint32_t c) {
+            if(mirrored) std::swap(b, c);
+            indices.insert(indices.end(), { a, b, c });
+        };
+
+        for(size_t row = 0; row + 1 < grid.rows; ++row) {
+            const uint32_t* bottom = vertex.data() + row * grid.columns;
+            const uint32_t* top = bottom + grid.columns;
+
+            for(size_t column = 0; column + 1 < grid.columns; ++column) {
+                uint32_t v00 = bottom[column], v10 = bottom[column + 1];
+                uint32_t v01 = top[column], v11 = top[column + 1];
+
+                int present = (v00 != absent) + (v10 != absent) + (v01 != absent) + (v11 != absent);
+
+                if(present == 4) {
+                    emit(v00, v10, v11);
+                    emit(v00, v11, v01);
+                } else if(present == 3) {
+                    if(v00 == absent) emit(v10, v11, v01);
+                    else if(v10 == absent) emit(v00, v11, v01);
+                    else if(v11 == absent) emit(v00, v10, v01);
+                    else emit(v00, v10, v11);
+                }
+            }
+        }
+    }
+
+    mesh triangulate_raster(const raster& grid, const std::vector<uint8_t>& mask) {
+        mesh m;
+        triangulate_raster(grid, mask, m.indices);
+
+        m.vertices.reserve(grid.size());
+        for(size_t row = 0; row < grid.rows; ++row) {
+            for(size_t column = 0; column < grid.columns; ++column) {
+                if(mask.empty() || mask[row * grid.columns + column]) m.vertices.push_back(grid.at(column, row));
+            }
+        }
+
+        m.constraints.assign(m.size(), 0);
+        m.connect();
+        m.trace_hull();
+
+        return m;
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "geometry.h"
+#include "mesh.h"
+
+namespace delaunay {
+    // Axis-aligned regular grid of nodes, numbered row by row
+    class raster {
+    public:
+        size_t columns, rows;
+
+        // Position of node (0, 0) and the distance between nodes
+        double origin_x, origin_y;
+        double spacing_x, spacing_y;
+
+        raster(size_t columns, size_t rows, double origin_x = 0.0, double origin_y = 0.0,
+               double spacing_x = 1.0, double spacing_y = 1.0);
+
+        size_t size() const;
+        point at(size_t column, size_t row) const;
+    };
+
+    // Nodes whose height is neither `nodata` nor NaN
+    std::vector<uint8_t> raster_mask(const std::vector<double>& heights, double nodata);
+
+    /*
+    ** Triangulate the nodes of a raster in one linear pass, without any
+    ** geometric search. `mask` has one entry per node, non-zero where the
+    ** node is present; an empty mask keeps every node. Vertices are the
+    ** present nodes, numbered row by row.
+    **
+    ** A cell with all four corners present is split along the diagonal from
+    ** node (c, r) to node (c + 1, r + 1); a cell with three corners
+    ** becomes one triangle. The corners of a cell are cocircular, so every
+    ** triangle is Delaunay, but cells with fewer corners are left empty:
+    ** holes and concave outlines of the mask are kept, not filled in.
+     */
+    void triangulate_raster(const raster& grid, const std::vector<uint8_t>& mask,
+                            std::vector<uint32_t>& indices);
+    mesh triangulate_raster(const raster& grid, const std::vector<uint8_t>& mask = {});
+}
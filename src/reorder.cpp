@@ -0,0 +1,259 @@
+#include "reorder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "parallel.h"
+#include "trace.h"
+
+namespace delaunay {
+    namespace {
+        // Cells per side of the Hilbert curve grid
+        const uint32_t side = 1u << 16;
+
+        // Distance along the Hilbert curve of cell (x, y)
+        uint32_t hilbert(uint32_t x, uint32_t y) {
+            uint32_t d = 0;
+
+            for(uint32_t s = side / 2; s > 0; s /= 2) {
+                uint32_t rx = (x & s) > 0, ry = (y & s) > 0;
+                d += s * s * ((3 * rx) ^ ry);
+
+                // Rotate the quadrant so the curve enters it the same way
+                if(ry == 0) {
+                    if(rx == 1) {
+                        x = side - 1 - x;
+                        y = side - 1 - y;
+                    }
+
+                    std::swap(x, y);
+                }
+            }
+
+            return d;
+        }
+
+        // Renumber the mesh after the permutation
+        void apply(mesh& m, const reordering& order) {
+            const uint32_t none = mesh::none;
+
+            std::vector<uint32_t> vertex_rank(m.vertices.size()), triangle_rank(m.size());
+            for(uint32_t v = 0; v < order.vertices.size(); ++v) vertex_rank[order.vertices[v]] = v;
+            for(uint32_t t = 0; t < order.triangles.size(); ++t) triangle_rank[order.triangles[t]] = t;
+
+            std::vector<point> vertices(m.vertices.size());
+            for(size_t v = 0; v < vertices.size(); ++v) vertices[v] = m.vertices[order.vertices[v]];
+
+            std::vector<uint32_t> indices(m.indices.size()), neighbors(m.neighbors.size());
+            std::vector<uint8_t> constraints(m.constraints.size());
+
+            for(size_t t = 0; t < m.size(); ++t) {
+                uint32_t old = order.triangles[t];
+
+                for(uint32_t k = 0; k < 3; ++k) {
+                    indices[3 * t + k] = vertex_rank[m.indices[3 * old + k]];
+
+                    uint32_t u = m.neighbors[3 * old + k];
+                    neighbors[3 * t + k] = u == none ? none : triangle_rank[u];
+                }
+
+                if(!constraints.empty()) constraints[t] = m.constraints[old];
+            }
+
+            for(uint32_t& v : m.hull) v = vertex_rank[v];
+
+            m.vertices = std::move(vertices);
+            m.indices = std::move(indices);
+            m.neighbors = std::move(neighbors);
+            m.constraints = std::move(constraints);
+        }
+
+        /* Vertex score of Forsyth's optimization: the three most recent
+        ** vertices score a fixed amount (to not favor the very triangle just
+        ** emitted), older cache entries decay, and vertices with few
+        ** triangles left get a boost so they are finished off.
+         */
+        float vertex_score(uint32_t position, uint32_t remaining, size_t cache_size) {
+            const float decay = 1.5f, last_triangle = 0.75f;
+            const float valence_scale = 2.0f, valence_power = 0.5f;
+
+            if(remaining == 0) return -1.0f;
+
+            float score = 0.0f;
+            if(position < 3) {
+                score = last_triangle;
+            } else if(position < cache_size) {
+                float scale = 1.0f / static_cast<float>(cache_size - 3);
+                score = std::pow(1.0f - static_cast<float>(position - 3) * scale, decay);
+            }
+
+            return score + valence_scale * std::pow(static_cast<float>(remaining), -valence_power);
+        }
+    }
+
+    std::vector<uint32_t> hilbert_order(const std::vector<point>& points, unsigned threads) {
+        trace_span span("hilbert order");
+
+        if(points.empty()) return {};
+
+        point min = points[0], max = points[0];
+        for(const point& p : points) {
+            min = point(std::min(min.x, p.x), std::min(min.y, p.y));
+            max = point(std::max(max.x, p.x), std::max(max.y, p.y));
+        }
+
+        // One scale for both axes keeps the curve's locality
+        double extent = std::max(max.x - min.x, max.y - min.y);
+        double scale = extent > 0.0 ? (side - 1) / extent : 0.0;
+
+        std::vector<uint64_t> keys(points.size());
+        std::vector<uint32_t> order(points.size());
+
+        for(size_t i = 0; i < points.size(); ++i) {
+            uint32_t x = static_cast<uint32_t>((points[i].x - min.x) * scale);
+            uint32_t y = static_cast<uint32_t>((points[i].y - min.y) * scale);
+
+            keys[i] = hilbert(std::min(x, side - 1), std::min(y, side - 1));
+            order[i] = static_cast<uint32_t>(i);
+        }
+
+        // Stable, so points in one cell keep their input order
+        radix_sort(keys, order, threads);
+        return order;
+    }
+
+    reordering reorder_hilbert(mesh& m, unsigned threads) {
+        trace_span span("reorder");
+
+        std::vector<point> centroids(m.size());
+        for(size_t t = 0; t < m.size(); ++t) {
+            const point& a = m.vertices[m.indices[3 * t]];
+            const point& b = m.vertices[m.indices[3 * t + 1]];
+            const point& c = m.vertices[m.indices[3 * t + 2]];
+
+            centroids[t] = point((a.x + b.x + c.x) / 3.0, (a.y + b.y + c.y) / 3.0);
+        }
+
+        reordering order;
+        order.vertices = hilbert_order(m.vertices, threads);
+        order.triangles = hilbert_order(centroids, threads);
+
+        apply(m, order);
+        return order;
+    }
+
+    reordering reorder_vertex_cache(mesh& m, size_t cache_size) {
+        trace_span span("reorder");
+
+        const uint32_t none = mesh::none;
+        const size_t count = m.size();
+
+        // Triangles around every vertex; the first remaining[v] are not yet emitted
+        std::vector<uint32_t> offsets(m.vertices.size() + 1, 0), around(m.indices.size());
+        for(uint32_t v : m.indices) ++offsets[v + 1];
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+        std::vector<uint32_t> remaining(m.vertices.size(), 0);
+        for(uint32_t slot = 0; slot < m.indices.size(); ++slot) {
+            uint32_t v = m.indices[slot];
+            around[offsets[v] + remaining[v]++] = slot / 3;
+        }
+
+        std::vector<uint32_t> position(m.vertices.size(), none);
+        std::vector<float> scores(m.vertices.size());
+        for(size_t v = 0; v < scores.size(); ++v) scores[v] = vertex_score(none, remaining[v], cache_size);
+
+        std::vector<float> triangle_scores(count);
+        std::vector<uint8_t> emitted(count, 0);
+
+        for(size_t t = 0; t < count; ++t) {
+            const uint32_t* v = &m.indices[3 * t];
+            triangle_scores[t] = scores[v[0]] + scores[v[1]] + scores[v[2]];
+        }
+
+        reordering order;
+        order.triangles.reserve(count);
+
+        std::vector<uint32_t> cache, next;
+        cache.reserve(cache_size + 3);
+        next.reserve(cache_size + 3);
+
+        uint32_t best = count ? static_cast<uint32_t>(
+            std::max_element(triangle_scores.begin(), triangle_scores.end()) - triangle_scores.begin()) : none;
+
+        // Where to look for a fresh start when nothing in the cache is left
+        size_t cursor = 0;
+
+        while(order.triangles.size() < count) {
+            if(best == none) {
+                while(emitted[cursor]) ++cursor;
+                best = static_cast<uint32_t>(cursor);
+            }
+
+            emitted[best] = 1;
+            order.triangles.push_back(best);
+
+            // Move the vertices to the front of the cache
+            next.clear();
+            for(uint32_t k = 0; k < 3; ++k) {
+                uint32_t v = m.indices[3 * best + k];
+                next.push_back(v);
+
+                uint32_t* first = &around[offsets[v]];
+                uint32_t* last = first + remaining[v];
+                std::iter_swap(std::find(first, last, best), last - 1);
+                --remaining[v];
+            }
+
+            for(uint32_t v : cache) {
+                if(std::find(next.begin(), next.begin() + 3, v) == next.begin() + 3) next.push_back(v);
+            }
+
+            for(size_t i = 0; i < next.size(); ++i) position[next[i]] = i < cache_size ? static_cast<uint32_t>(i) : none;
+            std::swap(cache, next);
+
+            // Rescore what moved, and pick the best triangle around it
+            best = none;
+            float best_score = -1.0f;
+
+            for(uint32_t v : cache) scores[v] = vertex_score(position[v], remaining[v], cache_size);
+
+            for(uint32_t v : cache) {
+                for(uint32_t i = offsets[v]; i < offsets[v] + remaining[v]; ++i) {
+                    uint32_t t = around[i];
+                    const uint32_t* w = &m.indices[3 * t];
+
+                    triangle_scores[t] = scores[w[0]] + scores[w[1]] + scores[w[2]];
+                    if(triangle_scores[t] > best_score) {
+                        best_score = triangle_scores[t];
+                        best = t;
+                    }
+                }
+            }
+
+            if(cache.size() > cache_size) cache.resize(cache_size);
+        }
+
+        // Vertices by first use; unused ones keep their order at the end
+        std::vector<uint8_t> numbered(m.vertices.size(), 0);
+        order.vertices.reserve(m.vertices.size());
+
+        for(uint32_t t : order.triangles) {
+            for(uint32_t k = 0; k < 3; ++k) {
+                uint32_t v = m.indices[3 * t + k];
+                if(numbered[v]) continue;
+
+                numbered[v] = 1;
+                order.vertices.push_back(v);
+            }
+        }
+
+        for(uint32_t v = 0; v < m.vertices.size(); ++v) {
+            if(!numbered[v]) order.vertices.push_back(v);
+        }
+
+        apply(m, order);
+        return order;
+    }
+}
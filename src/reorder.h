@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "geometry.h"
+#include "mesh.h"
+
+namespace delaunay {
+    /*
+    ** Permutation applied to a mesh: new vertex i was vertices[i] and new
+    ** triangle t was triangles[t], so per-vertex or per-triangle data kept
+    ** alongside the mesh can follow it.
+     */
+    class reordering {
+    public:
+        std::vector<uint32_t> vertices;
+        std::vector<uint32_t> triangles;
+    };
+
+    // Indices of the points in the order a Hilbert curve over their bounding
+    // box visits them, nearby points staying close in the order
+    std::vector<uint32_t> hilbert_order(const std::vector<point>& points, unsigned threads = 0);
+
+    // Sort the vertices along a Hilbert curve, and the triangles along the
+    // same curve by their centroids
+    reordering reorder_hilbert(mesh& m, unsigned threads = 0);
+
+    /*
+    ** Order the triangles for a post-transform vertex cache of `cache_size`
+    ** entries (Forsyth's linear-speed optimization), greedily emitting the
+    ** triangle whose vertices are most recent in the cache or have the
+    ** fewest triangles left, then number the vertices by first use.
+     */
+    reordering reorder_vertex_cache(mesh& m, size_t cache_size = 32);
+}
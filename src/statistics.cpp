@@ -0,0 +1,18 @@
+#include "statistics.h"
+
+namespace delaunay {
+    statistics::statistics():
+        points(0), incircle_tests(0), halfplane_tests(0), boundary_comparisons(0),
+        triangles_created(0), triangles_destroyed(0), allocations(0),
+        cavity_sizes(), insert_time(0.0), cleanup_time(0.0) {}
+
+    void statistics::cavity(size_t size) {
+        size_t bucket = 0;
+        while(size > 0 && bucket + 1 < buckets) {
+            size >>= 1;
+            ++bucket;
+        }
+
+        ++cavity_sizes[bucket];
+    }
+}
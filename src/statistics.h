@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace delaunay {
+    /*
+    ** Counters gathered during one triangulation. They are only collected
+    ** when the library is built with DELAUNAY_STATISTICS (the CMake option
+    ** of the same name); otherwise the hooks compile away and every field
+    ** stays zero.
+     */
+    class statistics {
+    public:
+#ifdef DELAUNAY_STATISTICS
+        static constexpr bool enabled = true;
+#else
+        static constexpr bool enabled = false;
+#endif
+
+        // cavity_sizes[0] counts insertions invalidating no triangle (duplicate
+        // points), cavity_sizes[i] those invalidating [2^(i-1), 2^i) triangles,
+        // and the last bucket takes everything larger
+        static constexpr size_t buckets = 16;
+
+        uint64_t points;
+
+        // circle::contains and halfplane_contains evaluations
+        uint64_t incircle_tests;
+        uint64_t halfplane_tests;
+
+        // Edge comparisons while tracing the boundary of each cavity
+        uint64_t boundary_comparisons;
+
+        uint64_t triangles_created;
+        uint64_t triangles_destroyed;
+
+        // Heap allocations made by the triangulation's own containers
+        uint64_t allocations;
+
+        uint64_t cavity_sizes[buckets];
+
+        // Wall time in seconds
+        double insert_time;
+        double cleanup_time;
+
+        statistics();
+
+        // Record a cavity of the given number of triangles
+        void cavity(size_t size);
+    };
+}
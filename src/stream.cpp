@@ -0,0 +1,146 @@
+#include "stream.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "engine.h"
+#include "trace.h"
+
+namespace delaunay {
+    /* The engine's cells over the points still in use. The number of points
+    ** is not known in advance, so the ghosts take the highest indices the
+    ** engine allows, and points are renumbered as they are released.
+     */
+    class streaming_triangulator::workspace: public engine::buffers<circle_kernel> {
+    public:
+        static constexpr uint32_t ghost = UINT32_MAX - 3;
+
+        std::vector<point> points;
+        std::vector<uint32_t> renumber;
+
+        // Streamed points carry no weight
+        const std::vector<double> weights;
+
+        engine::triangulation<circle_kernel> triangulation() {
+            return engine::triangulation<circle_kernel>(*this, points, weights, ghost, nullptr);
+        }
+    };
+
+    streaming_triangulator::streaming_triangulator(sink output):
+        output(std::move(output)),
+        scratch(new workspace()),
+        sweep(-std::numeric_limits<double>::infinity()),
+        finished(false) {
+        scratch->triangulation().reset();
+    }
+
+    streaming_triangulator::streaming_triangulator(streaming_triangulator&& other) = default;
+    streaming_triangulator& streaming_triangulator::operator=(streaming_triangulator&& other) = default;
+    streaming_triangulator::~streaming_triangulator() {}
+
+    void streaming_triangulator::insert(const std::vector<point>& chunk) {
+        if(finished) throw std::logic_error("streaming triangulation already finished");
+
+        trace_span span("stream insert");
+
+        engine::triangulation<circle_kernel> triangulation = scratch->triangulation();
+
+        for(const point& p : chunk) {
+            if(p.x < sweep) {
+                throw std::invalid_argument("point lies behind the finalized sweep");
+            }
+
+            if(scratch->points.size() >= workspace::ghost) throw std::length_error("too many points");
+
+            scratch->points.push_back(p);
+            triangulation.insert(static_cast<uint32_t>(scratch->points.size() - 1));
+        }
+    }
+
+    void streaming_triangulator::finalize(double x) {
+        if(x <= sweep) return;
+        sweep = x;
+
+        trace_span span("finalize");
+
+        using cell = engine::cell<circle_kernel>;
+
+        engine::triangulation<circle_kernel> triangulation = scratch->triangulation();
+        std::vector<cell>& cells = scratch->cells;
+
+        /* The radius is squared and is the smallest distance from the center
+        ** to a vertex, which is exactly what circle::contains compares
+        ** against. A future point p has p.x >= sweep, so if the circle ends
+        ** before the sweep, p is at least sqrt(radius) from the center.
+         */
+        auto retired = [&](const cell& c) {
+            if(!circle_kernel::finite(c.circumcircle)) return false;
+
+            return c.circumcircle.center.x + std::sqrt(c.circumcircle.radius) <= sweep;
+        };
+
+        auto active_end = std::partition(cells.begin(), cells.end(),
+                                         [&](const cell& c) { return !retired(c); });
+
+        for(auto it = active_end; it != cells.end(); ++it) {
+            output(triangle(triangulation.vertex(it->v[0]), triangulation.vertex(it->v[1]),
+                            triangulation.vertex(it->v[2])));
+        }
+
+        cells.erase(active_end, cells.end());
+
+        /* A point that no remaining cell uses is never used again, as new
+        ** cells only join a point to the edges of the cells it replaces. The
+        ** points still in use move to the front, keeping their order.
+         */
+        std::vector<point>& points = scratch->points;
+        std::vector<uint32_t>& renumber = scratch->renumber;
+        renumber.assign(points.size(), engine::dead);
+
+        for(const cell& c : cells) {
+            for(uint32_t v : c.v) {
+                if(v < workspace::ghost) renumber[v] = 0;
+            }
+        }
+
+        uint32_t kept = 0;
+        for(uint32_t v = 0; v < points.size(); ++v) {
+            if(renumber[v] == engine::dead) continue;
+
+            points[kept] = points[v];
+            renumber[v] = kept++;
+        }
+
+        points.resize(kept);
+
+        for(cell& c : cells) {
+            for(uint32_t& v : c.v) {
+                if(v < workspace::ghost) v = renumber[v];
+            }
+        }
+    }
+
+    void streaming_triangulator::finish() {
+        if(finished) return;
+        finished = true;
+
+        trace_span span("finish");
+
+        engine::triangulation<circle_kernel> triangulation = scratch->triangulation();
+
+        for(const engine::cell<circle_kernel>& c : scratch->cells) {
+            if(std::max({ c.v[0], c.v[1], c.v[2] }) >= workspace::ghost) continue;
+
+            output(triangle(triangulation.vertex(c.v[0]), triangulation.vertex(c.v[1]),
+                            triangulation.vertex(c.v[2])));
+        }
+
+        scratch.reset(new workspace());
+    }
+
+    size_t streaming_triangulator::active() const {
+        return scratch->cells.size();
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "geometry.h"
+
+namespace delaunay {
+    /*
+    ** Streaming triangulation over a sweep in x.
+    **
+    ** Points arrive in chunks. After a chunk, the caller may finalize a sweep
+    ** position: a promise that every point still to come has x >= that value.
+    ** Any triangle whose circumcircle lies entirely to the left of the sweep
+    ** can never be invalidated again, so it is handed to the sink and dropped.
+    ** Only the active front of triangles remains in memory.
+     */
+    class streaming_triangulator {
+    public:
+        using sink = std::function<void(const triangle&)>;
+
+        explicit streaming_triangulator(sink output);
+        streaming_triangulator(streaming_triangulator&& other);
+        streaming_triangulator& operator=(streaming_triangulator&& other);
+        ~streaming_triangulator();
+
+        void insert(const std::vector<point>& chunk);
+
+        // Promise that every future point has x >= sweep
+        void finalize(double sweep);
+
+        // Flush the remaining triangles; no point may be inserted afterwards
+        void finish();
+
+        // Number of triangles still held in memory
+        size_t active() const;
+
+    private:
+        class workspace;
+
+        sink output;
+        std::unique_ptr<workspace> scratch;
+        double sweep;
+        bool finished;
+    };
+}
@@ -0,0 +1,308 @@
+#include "tiling.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "delaunay.h"
+#include "hull.h"
+#include "parallel.h"
+#include "trace.h"
+
+namespace delaunay {
+    namespace {
+        class rect {
+        public:
+            double min_x, min_y, max_x, max_y;
+
+            bool contains(const point& p) const {
+                return p.x >= min_x && p.x <= max_x && p.y >= min_y && p.y <= max_y;
+            }
+
+            bool contains(const rect& r) const {
+                return r.min_x >= min_x && r.max_x <= max_x &&
+                       r.min_y >= min_y && r.max_y <= max_y;
+            }
+        };
+
+        bool less(const point& a, const point& b) {
+            return a.x < b.x || (a.x == b.x && a.y < b.y);
+        }
+
+        // Counter-clockwise, starting at the smallest vertex
+        triangle canonical(triangle t) {
+            if(point::orientation(t.a, t.b, t.c) < 0.0) std::swap(t.b, t.c);
+
+            if(less(t.b, t.a) && less(t.b, t.c)) return triangle(t.b, t.c, t.a);
+            if(less(t.c, t.a) && less(t.c, t.b)) return triangle(t.c, t.a, t.b);
+
+            return t;
+        }
+
+        bool canonical_less(const triangle& a, const triangle& b) {
+            if(less(a.a, b.a) || less(b.a, a.a)) return less(a.a, b.a);
+            if(less(a.b, b.b) || less(b.b, a.b)) return less(a.b, b.b);
+            return less(a.c, b.c);
+        }
+
+        // Every point of the data that could lie in the circle is in the region
+        bool circle_resolved(const circle& c, const rect& bounds, const rect& region) {
+            /* Bounding box of the disk clipped to the data bounds. Along x,
+            ** the disk is widest at the height of the bounds closest to its
+            ** center, and likewise along y.
+             */
+            double dx = std::max({ 0.0, bounds.min_x - c.center.x, c.center.x - bounds.max_x });
+            double dy = std::max({ 0.0, bounds.min_y - c.center.y, c.center.y - bounds.max_y });
+
+            if(dx * dx >= c.radius || dy * dy >= c.radius) return true;
+
+            double half_width = std::sqrt(c.radius - dy * dy);
+            double half_height = std::sqrt(c.radius - dx * dx);
+
+            rect reach = {
+                std::max(c.center.x - half_width, bounds.min_x),
+                std::max(c.center.y - half_height, bounds.min_y),
+                std::min(c.center.x + half_width, bounds.max_x),
+                std::min(c.center.y + half_height, bounds.max_y)
+            };
+
+            return region.contains(reach);
+        }
+
+        // Whether no point of the data lies beyond (to the right of) the
+        // line a -> b, given the vertices of the global convex hull
+        bool on_hull(const point& a, const point& b, const std::vector<point>& hull) {
+            for(const point& h : hull) {
+                if(point::orientation(a, b, h) < 0.0) return false;
+            }
+
+            return true;
+        }
+
+        // Every point of the data that could lie beyond the hull edge a -> b
+        // (to its right) is in the region
+        bool halfplane_resolved(const point& a, const point& b, const rect& bounds, const rect& region) {
+            point corners[4] = {
+                point(bounds.min_x, bounds.min_y), point(bounds.max_x, bounds.min_y),
+                point(bounds.max_x, bounds.max_y), point(bounds.min_x, bounds.max_y)
+            };
+
+            // Clip the bounding box against the closed outer half-plane
+            for(int i = 0; i < 4; ++i) {
+                const point& p = corners[i];
+                const point& q = corners[(i + 1) % 4];
+
+                double side_p = point::orientation(a, b, p);
+                double side_q = point::orientation(a, b, q);
+
+                if(side_p <= 0.0 && !region.contains(p)) return false;
+
+                if((side_p < 0.0 && side_q > 0.0) || (side_p > 0.0 && side_q < 0.0)) {
+                    double t = side_p / (side_p - side_q);
+                    point crossing(p.x + t * (q.x - p.x), p.y + t * (q.y - p.y));
+                    if(!region.contains(crossing)) return false;
+                }
+            }
+
+            return true;
+        }
+    }
+
+    tiling::tiling(size_t columns, size_t rows, double halo, unsigned threads):
+        columns(std::max<size_t>(columns, 1)), rows(std::max<size_t>(rows, 1)),
+        halo(halo), threads(threads) {}
+
+    size_t tile_plan::tile_count() const {
+        return grid.columns * grid.rows;
+    }
+
+    size_t tile_plan::tile_of(const point& p) const {
+        double width = (max_x - min_x) / grid.columns;
+        double height = (max_y - min_y) / grid.rows;
+
+        size_t column = 0, row = 0;
+        if(width > 0.0 && p.x > min_x) {
+            column = std::min(grid.columns - 1, static_cast<size_t>((p.x - min_x) / width));
+        }
+
+        if(height > 0.0 && p.y > min_y) {
+            row = std::min(grid.rows - 1, static_cast<size_t>((p.y - min_y) / height));
+        }
+
+        return row * grid.columns + column;
+    }
+
+    tile_plan plan_tiles(const std::vector<point>& points, const tiling& grid) {
+        tile_plan plan;
+        plan.grid = grid;
+        plan.min_x = plan.max_x = points.empty() ? 0.0 : points[0].x;
+        plan.min_y = plan.max_y = points.empty() ? 0.0 : points[0].y;
+
+        for(const point& p : points) {
+            plan.min_x = std::min(plan.min_x, p.x);
+            plan.min_y = std::min(plan.min_y, p.y);
+            plan.max_x = std::max(plan.max_x, p.x);
+            plan.max_y = std::max(plan.max_y, p.y);
+        }
+
+        for(uint32_t i : convex_hull(points)) plan.hull.push_back(points[i]);
+
+        return plan;
+    }
+
+    std::vector<std::vector<point>> bucket_points(const std::vector<point>& points, const tile_plan& plan) {
+        std::vector<std::vector<point>> buckets(plan.tile_count());
+        for(const point& p : points) buckets[plan.tile_of(p)].push_back(p);
+
+        return buckets;
+    }
+
+    std::vector<triangle> triangulate_tile(const tile_plan& plan, size_t tile,
+                                           const std::function<const std::vector<point>&(size_t)>& bucket) {
+        const tiling& grid = plan.grid;
+        const std::vector<point>& own = bucket(tile);
+
+        std::vector<triangle> out;
+        if(own.empty()) return out;
+
+        trace_span tile_span("tile", tile);
+
+        rect bounds = { plan.min_x, plan.min_y, plan.max_x, plan.max_y };
+        double width = (bounds.max_x - bounds.min_x) / grid.columns;
+        double height = (bounds.max_y - bounds.min_y) / grid.rows;
+
+        size_t column = tile % grid.columns;
+        size_t row = tile / grid.columns;
+
+        rect core = {
+            bounds.min_x + column * width, bounds.min_y + row * height,
+            bounds.min_x + (column + 1) * width, bounds.min_y + (row + 1) * height
+        };
+
+        double halo = grid.halo * std::max(width, height);
+        if(halo <= 0.0) halo = std::max(width, height);
+
+        for(;;) {
+            rect region = { core.min_x - halo, core.min_y - halo,
+                            core.max_x + halo, core.max_y + halo };
+
+            // Once the halo reaches past the data, this is the global triangulation
+            bool complete = region.contains(bounds) || halo <= 0.0;
+
+            size_t first = plan.tile_of(point(region.min_x, region.min_y));
+            size_t last = plan.tile_of(point(region.max_x, region.max_y));
+
+            // Keep this tile's own points first, so they are easy to recognize
+            std::vector<point> local = own;
+            size_t owned = local.size();
+
+            for(size_t r = first / grid.columns; r <= last / grid.columns; ++r) {
+                for(size_t c = first % grid.columns; c <= last % grid.columns; ++c) {
+                    size_t other = r * grid.columns + c;
+                    if(other == tile) continue;
+
+                    for(const point& p : bucket(other)) {
+                        if(region.contains(p)) local.push_back(p);
+                    }
+                }
+            }
+
+            // Ties are broken by the points alone, so that every tile
+            // reaching a triangle picks the same one
+            mesh m;
+            m.vertices = local;
+            triangulate_with<exact_kernel>(local, m.indices, m.hull);
+            m.constraints.assign(m.size(), 0);
+            m.connect();
+
+            bool resolved = true;
+            std::vector<bool> referenced(local.size(), false);
+
+            for(size_t t = 0; t < m.size() && resolved; ++t) {
+                const uint32_t* v = &m.indices[3 * t];
+
+                for(int i = 0; i < 3; ++i) referenced[v[i]] = true;
+
+                if(complete) continue;
+                if(v[0] >= owned && v[1] >= owned && v[2] >= owned) continue;
+
+                resolved = circle_resolved(m.at(t).circumcircle(), bounds, region);
+
+                for(int i = 0; i < 3 && resolved; ++i) {
+                    if(m.neighbors[3 * t + i] != mesh::none) continue;
+
+                    const point& a = m.vertices[v[i]];
+                    const point& b = m.vertices[v[(i + 1) % 3]];
+
+                    resolved = on_hull(a, b, plan.hull) || halfplane_resolved(a, b, bounds, region);
+                }
+            }
+
+            if(resolved && !complete) {
+                // A tile point outside every local triangle only has a
+                // known star if it is a duplicate of a point that does
+                std::vector<point> used;
+                for(size_t i = 0; i < local.size(); ++i) {
+                    if(referenced[i]) used.push_back(local[i]);
+                }
+
+                std::sort(used.begin(), used.end(), less);
+
+                for(size_t i = 0; i < owned && resolved; ++i) {
+                    if(referenced[i]) continue;
+
+                    auto it = std::lower_bound(used.begin(), used.end(), local[i], less);
+                    resolved = it != used.end() && it->x == local[i].x && it->y == local[i].y;
+                }
+            }
+
+            if(!resolved) {
+                halo *= 2.0;
+                continue;
+            }
+
+            for(size_t t = 0; t < m.size(); ++t) {
+                triangle c = canonical(m.at(t));
+                if(plan.tile_of(c.a) == tile) out.push_back(c);
+            }
+
+            std::sort(out.begin(), out.end(), canonical_less);
+            return out;
+        }
+    }
+
+    std::vector<triangle> merge_tiles(std::vector<std::vector<triangle>>& results) {
+        trace_span merge_span("merge");
+
+        size_t total = 0;
+        for(const std::vector<triangle>& r : results) total += r.size();
+
+        std::vector<triangle> triangulation;
+        triangulation.reserve(total);
+
+        for(std::vector<triangle>& r : results) {
+            triangulation.insert(triangulation.end(), r.begin(), r.end());
+        }
+
+        return triangulation;
+    }
+
+    std::vector<triangle> triangulate_tiled(const std::vector<point>& points, const tiling& grid) {
+        if(points.empty()) return {};
+
+        trace_span span("triangulate tiled");
+
+        tile_plan plan = plan_tiles(points, grid);
+        std::vector<std::vector<point>> buckets = bucket_points(points, plan);
+        std::vector<std::vector<triangle>> results(buckets.size());
+
+        auto bucket = [&](size_t tile) -> const std::vector<point>& {
+            return buckets[tile];
+        };
+
+        parallel_for(buckets.size(), grid.threads, [&](size_t tile) {
+            results[tile] = triangulate_tile(plan, tile, bucket);
+        });
+
+        return merge_tiles(results);
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "geometry.h"
+
+namespace delaunay {
+    class tiling {
+    public:
+        // Tile grid laid over the bounding box of the input
+        size_t columns;
+        size_t rows;
+
+        // Initial halo around each tile, as a fraction of the tile size.
+        // Tiles whose result cannot be proven final retry with twice the halo.
+        double halo;
+
+        // Worker threads, 0 to use every hardware thread
+        unsigned threads;
+
+        tiling(size_t columns = 1, size_t rows = 1, double halo = 0.5, unsigned threads = 0);
+    };
+
+    /*
+    ** Triangulate tile by tile, each tile together with a halo of its
+    ** neighbors' points. A tile only keeps triangles whose smallest vertex
+    ** lies in the tile, and only once every triangle and hull edge around
+    ** its own vertices is proven to be globally Delaunay, so each triangle
+    ** of the global triangulation is produced exactly once and in a
+    ** canonical form: counter-clockwise, starting at its smallest vertex.
+    ** Tiles triangulate with exact_kernel, so ties between cocircular
+    ** points are broken the same way in every tile, though not
+    ** necessarily as triangulate() breaks them.
+     */
+    std::vector<triangle> triangulate_tiled(const std::vector<point>& points, const tiling& grid);
+
+    /*
+    ** The same work split into steps that can run in separate processes or
+    ** on separate machines: plan once over all points, bucket the points by
+    ** tile, triangulate every tile wherever its neighbors' buckets can be
+    ** read, and merge the results. triangulate_tiled does exactly this on a
+    ** thread pool.
+     */
+
+    // Everything a tile needs besides points, the same for every tile
+    class tile_plan {
+    public:
+        tiling grid;
+
+        // Bounds of the data, and the vertices of its convex hull
+        double min_x, min_y, max_x, max_y;
+        std::vector<point> hull;
+
+        size_t tile_count() const;
+
+        // Tile whose core holds p, numbered row by row
+        size_t tile_of(const point& p) const;
+    };
+
+    tile_plan plan_tiles(const std::vector<point>& points, const tiling& grid);
+
+    // The points of every tile, in input order
+    std::vector<std::vector<point>> bucket_points(const std::vector<point>& points, const tile_plan& plan);
+
+    /*
+    ** The triangles of one tile, in canonical form and order. bucket(t)
+    ** gives the points of tile t (as bucket_points does); it is called for
+    ** the tile itself and for the neighbors its halo reaches, more of them
+    ** as the halo grows.
+     */
+    std::vector<triangle> triangulate_tile(const tile_plan& plan, size_t tile,
+                                           const std::function<const std::vector<point>&(size_t)>& bucket);
+
+    // Concatenate the tiles' results, in tile order, into the triangulation
+    std::vector<triangle> merge_tiles(std::vector<std::vector<triangle>>& results);
+}
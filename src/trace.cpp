@@ -0,0 +1,91 @@
+#include "trace.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace delaunay {
+    namespace {
+        std::atomic<tracer*> installed(nullptr);
+
+        // Small, stable thread numbers read better in a viewer than native ids
+        uint32_t thread_number() {
+            static std::atomic<uint32_t> next(0);
+            thread_local uint32_t number = next++;
+
+            return number;
+        }
+    }
+
+    tracer::tracer(): origin(clock::now()) {}
+
+    void tracer::install(tracer* t) {
+        installed.store(t, std::memory_order_release);
+    }
+
+    tracer* tracer::current() {
+        return installed.load(std::memory_order_acquire);
+    }
+
+    void tracer::record(const char* name, int64_t index, clock::time_point start, clock::time_point end) {
+        uint32_t thread = thread_number();
+
+        std::lock_guard<std::mutex> guard(lock);
+        events.push_back({ name, index, thread, start, end });
+    }
+
+    size_t tracer::size() const {
+        std::lock_guard<std::mutex> guard(lock);
+        return events.size();
+    }
+
+    double tracer::seconds(const char* name) const {
+        std::lock_guard<std::mutex> guard(lock);
+
+        double total = 0.0;
+        for(const event& e : events) {
+            if(std::strcmp(e.name, name) == 0) total += std::chrono::duration<double>(e.end - e.start).count();
+        }
+
+        return total;
+    }
+
+    void tracer::write(const std::string& path) const {
+        std::FILE* file = std::fopen(path.c_str(), "w");
+        if(!file) throw std::runtime_error("unable to open " + path);
+
+        auto microseconds = [&](clock::time_point t) {
+            return std::chrono::duration<double, std::micro>(t - origin).count();
+        };
+
+        std::lock_guard<std::mutex> guard(lock);
+
+        // Complete ("X") events; names are library literals and need no escaping
+        std::fprintf(file, "{\"traceEvents\":[");
+        for(size_t i = 0; i < events.size(); ++i) {
+            const event& e = events[i];
+
+            std::fprintf(file, "%s\n{\"name\":\"%s\",\"cat\":\"delaunay\",\"ph\":\"X\","
+                         "\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u",
+                         i ? "," : "", e.name, microseconds(e.start),
+                         microseconds(e.end) - microseconds(e.start), e.thread);
+
+            if(e.index >= 0) std::fprintf(file, ",\"args\":{\"index\":%lld}", (long long)e.index);
+            std::fprintf(file, "}");
+        }
+
+        std::fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+        if(std::fclose(file) != 0) throw std::runtime_error("unable to write " + path);
+    }
+
+    trace_span::trace_span(const char* name, int64_t index):
+        target(tracer::current()), name(name), index(index) {
+        if(target) start = tracer::clock::now();
+    }
+
+    trace_span::~trace_span() {
+        if(target) target->record(name, index, start, tracer::clock::now());
+    }
+}
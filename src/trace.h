@@ -0,0 +1,67 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace delaunay {
+    /*
+    ** Opt-in timeline tracing. While a tracer is installed, the library
+    ** records spans for its phases (and for each worker thread in parallel
+    ** code); write() dumps them as Chrome trace JSON, which loads in
+    ** chrome://tracing and in Perfetto. With no tracer installed a span
+    ** costs a single atomic load.
+     */
+    class tracer {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        tracer();
+
+        // Make t the destination of every span, or stop tracing with nullptr
+        static void install(tracer* t);
+        static tracer* current();
+
+        // Span names must outlive the tracer, e.g. string literals
+        void record(const char* name, int64_t index, clock::time_point start, clock::time_point end);
+
+        size_t size() const;
+
+        // Total duration of the spans recorded under name, in seconds
+        double seconds(const char* name) const;
+
+        void write(const std::string& path) const;
+
+    private:
+        class event {
+        public:
+            const char* name;
+            int64_t index;
+            uint32_t thread;
+            clock::time_point start;
+            clock::time_point end;
+        };
+
+        clock::time_point origin;
+        mutable std::mutex lock;
+        std::vector<event> events;
+    };
+
+    // Records a span on the installed tracer for the lifetime of the object
+    class trace_span {
+    public:
+        // index tags repeated spans, e.g. a batch or tile number; -1 for none
+        explicit trace_span(const char* name, int64_t index = -1);
+        ~trace_span();
+
+        trace_span(const trace_span&) = delete;
+        trace_span& operator=(const trace_span&) = delete;
+
+    private:
+        tracer* target;
+        const char* name;
+        int64_t index;
+        tracer::clock::time_point start;
+    };
+}
@@ -1,9 +1,53 @@
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
 
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <new>
 #include <random>
+#include <set>
+#include <thread>
 
 #include <geometry.h>
+#include <alpha.h>
+#include <concurrent.h>
+#include <dedup.h>
+#include <degenerate.h>
 #include <delaunay.h>
+#include <graph.h>
+#include <hull.h>
+#include <io.h>
+#include <lloyd.h>
+#include <locate.h>
+#include <mesh.h>
+#include <parallel.h>
+#include <power.h>
+#include <raster.h>
+#include <reorder.h>
+#include <stream.h>
+#include <tiling.h>
+#include <trace.h>
+
+// Heap allocations made by this thread, counted in every build by
+// replacing the global operator new
+thread_local size_t heap_allocations = 0;
+
+void* operator new(size_t size) {
+	++heap_allocations;
+
+	if(void* memory = std::malloc(size ? size : 1)) return memory;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+	std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+	std::free(memory);
+}
 
 // Generate n points within a circle of the given radius
 std::vector<point> generate_points(int n, float radius) {
@@ -84,6 +128,83 @@ TEST_CASE("Collinear points have no triangulation", "[collinear]") {
 	REQUIRE(delaunay::triangulate(vertical_line).size() == 0);
 }
 
+TEST_CASE("Degenerate inputs are recognized and triangulated directly", "[degenerate]") {
+	std::vector<point> line = { point(2, 4), point(0, 0), point(3, 6), point(1, 2) };
+	REQUIRE(delaunay::classify(line) == delaunay::degeneracy::collinear);
+
+	mesh m = delaunay::triangulate_mesh(line);
+	REQUIRE(m.size() == 0);
+	REQUIRE(m.hull == std::vector<uint32_t>{ 1, 3, 0, 2 });
+
+	std::vector<point> circle;
+	for(int i = 0; i < 64; ++i) circle.emplace_back(5 + 3 * cos(i * 0.7), -2 + 3 * sin(i * 0.7));
+	REQUIRE(delaunay::classify(circle) == delaunay::degeneracy::cocircular);
+	REQUIRE(delaunay::triangulate(circle).size() == 62);
+
+	// Raster rows in any order
+	std::vector<point> raster;
+	for(int row = 9; row >= 0; --row) {
+		for(int column = 0; column < 20; ++column) raster.emplace_back(0.5 * column, 0.25 * row);
+	}
+
+	REQUIRE(delaunay::classify(raster) == delaunay::degeneracy::grid);
+	REQUIRE(valid_triangulation(raster));
+
+	// Spacings that are not exact in binary are still recognized
+	std::vector<point> inexact;
+	for(const point& p : raster) inexact.emplace_back(p.x / 5 - 3.7, p.y * 1.2 + 0.1);
+	REQUIRE(delaunay::classify(inexact) == delaunay::degeneracy::grid);
+
+	m = delaunay::triangulate_mesh(raster);
+	REQUIRE(m.size() == 2 * 19 * 9);
+	REQUIRE(m.hull.size() == 2 * (19 + 9));
+	REQUIRE(std::count(m.neighbors.begin(), m.neighbors.end(), mesh::none) == 2 * (19 + 9));
+
+	// Missing nodes fall back to the general triangulation
+	raster.pop_back();
+	REQUIRE(delaunay::classify(raster) == delaunay::degeneracy::general);
+	REQUIRE(delaunay::classify(generate_points(100, 10)) == delaunay::degeneracy::general);
+}
+
+TEST_CASE("Rasters are triangulated around missing nodes", "[raster]") {
+	delaunay::raster grid(6, 5, 100.0, 200.0, 0.5, 0.5);
+
+	mesh full = delaunay::triangulate_raster(grid);
+	REQUIRE(full.vertices.size() == 30);
+	REQUIRE(full.size() == 2 * 5 * 4);
+	REQUIRE(full.vertices[7] == grid.at(1, 1));
+	REQUIRE(full.hull.size() == 2 * (5 + 4));
+
+	// Same as the general triangulation of the same nodes
+	std::vector<point> nodes = full.vertices;
+	mesh general = delaunay::triangulate_mesh(nodes);
+	REQUIRE(general.indices == full.indices);
+
+	// Each cell around a missing interior node keeps the one triangle
+	// spanned by its other corners, and so does the cell at a missing corner
+	std::vector<double> heights(grid.size(), 1.0);
+	heights[2 * 6 + 2] = -9999.0;
+	heights[0] = std::nan("");
+
+	std::vector<uint8_t> mask = delaunay::raster_mask(heights, -9999.0);
+	mesh holed = delaunay::triangulate_raster(grid, mask);
+
+	REQUIRE(holed.vertices.size() == 28);
+	REQUIRE(holed.size() == full.size() - 4 - 1);
+	REQUIRE(holed.hull.empty());
+
+	for(size_t t = 0; t < holed.size(); ++t) {
+		const triangle& tri = holed.at(t);
+		REQUIRE((tri.b.x - tri.a.x) * (tri.c.y - tri.a.y) - (tri.c.x - tri.a.x) * (tri.b.y - tri.a.y) > 0.0);
+	}
+
+	// Mirrored grids stay counter-clockwise
+	mesh mirrored = delaunay::triangulate_raster(delaunay::raster(3, 3, 0.0, 0.0, 1.0, -1.0));
+	REQUIRE(mirrored.hull.size() == 8);
+
+	REQUIRE_THROWS(delaunay::triangulate_raster(grid, std::vector<uint8_t>(3, 1)));
+}
+
 TEST_CASE("Random points are triangulated", "[random]") {
 	REQUIRE(valid_triangulation(generate_points(25, 10)));
 	REQUIRE(valid_triangulation(generate_points(50, 10)));
@@ -91,3 +212,1200 @@ TEST_CASE("Random points are triangulated", "[random]") {
 	REQUIRE(valid_triangulation(generate_points(1000, 100)));
 	REQUIRE(valid_triangulation(generate_points(5000, 500)));
 }
+
+TEST_CASE("Points sorted along an axis are triangulated", "[random]") {
+	std::vector<point> points = generate_points(1000, 1);
+	size_t expected = delaunay::triangulate(points).size();
+
+	// Sorted input builds long fronts of near-vertical hull edges
+	std::sort(points.begin(), points.end(), [](const point& a, const point& b) {
+		return a.x < b.x;
+	});
+
+	REQUIRE(delaunay::triangulate(points).size() == expected);
+	REQUIRE(valid_triangulation(points));
+}
+
+TEST_CASE("Circles through an infinite vertex are half-planes", "[halfplane]") {
+	double inf = INFINITY;
+
+	// The circle through a vertical edge and a vertex far up is on the side
+	// of the origin, far right on the right and far down-left on the left
+	for(double x : { 1.0, -5.0 }) {
+		point a(x, 0), b(x, 1);
+		point left(x - 1, 0.5), right(x + 1, 0.5);
+
+		for(const triangle& t : { triangle(point(0, inf), a, b), triangle(b, point(0, inf), a) }) {
+			REQUIRE(delaunay::halfplane_contains(t, left) == (x > 0));
+			REQUIRE(delaunay::halfplane_contains(t, right) == (x < 0));
+		}
+
+		REQUIRE(delaunay::halfplane_contains(triangle(point(inf, 0), a, b), right));
+		REQUIRE_FALSE(delaunay::halfplane_contains(triangle(point(inf, 0), a, b), left));
+
+		REQUIRE(delaunay::halfplane_contains(triangle(point(-inf, -inf), a, b), left));
+		REQUIRE_FALSE(delaunay::halfplane_contains(triangle(point(-inf, -inf), a, b), right));
+	}
+}
+
+TEST_CASE("Integer points are triangulated exactly", "[kernel]") {
+	// A small grid offset so it is not recognized as one, full of cocircular points
+	std::mt19937 gen(6);
+	std::vector<point> points;
+	std::set<std::pair<int, int>> seen;
+
+	while(points.size() < 1000) {
+		int x = static_cast<int>(gen() % 40) - (1 << 25), y = static_cast<int>(gen() % 40) + (1 << 25);
+		if(seen.insert({ x, y }).second) points.emplace_back(x, y);
+	}
+
+	std::vector<uint32_t> indices, hull;
+	delaunay::triangulate_with<delaunay::grid_kernel>(points, indices, hull);
+
+	// Every triangulation of the points has this many triangles
+	size_t on_hull = 0;
+	for(const point& p : points) {
+		bool boundary = false;
+		for(size_t i = 0; i < hull.size(); ++i) {
+			const point& a = points[hull[i]];
+			const point& b = points[hull[(i + 1) % hull.size()]];
+			boundary |= (b.x - a.x) * (p.y - a.y) == (b.y - a.y) * (p.x - a.x) &&
+			            std::min(a.x, b.x) <= p.x && p.x <= std::max(a.x, b.x) &&
+			            std::min(a.y, b.y) <= p.y && p.y <= std::max(a.y, b.y);
+		}
+
+		on_hull += boundary;
+	}
+
+	REQUIRE(indices.size() / 3 == 2 * points.size() - 2 - on_hull);
+
+	for(size_t t = 0; t < indices.size(); t += 3) {
+		delaunay::grid_kernel::circumcircle c = delaunay::grid_kernel::make(
+			points[indices[t]], points[indices[t + 1]], points[indices[t + 2]]);
+
+		bool empty = true;
+		for(const point& p : points) empty &= !delaunay::grid_kernel::conflicts(c, p);
+		REQUIRE(empty);
+	}
+
+	// The side of this hull edge rounds to 0 in double precision
+	REQUIRE(delaunay::grid_kernel::beyond(point(-67108275, -67108321), point(67108239, 67108192),
+	                                      point(67108240, 67108193)));
+
+#ifdef __SIZEOF_INT128__
+	// The portable limbs agree with __int128 on products of in-circle size
+	std::uniform_int_distribution<int64_t> lifted(-(int64_t(1) << 55), int64_t(1) << 55);
+	std::uniform_int_distribution<int64_t> minor(-(int64_t(1) << 56), int64_t(1) << 56);
+	for(int i = 0; i < 10000; ++i) {
+		int64_t a = lifted(gen), b = minor(gen), c = lifted(gen), d = minor(gen);
+		delaunay::grid_kernel::limbs sum = delaunay::grid_kernel::limbs::product(a, b)
+		                                 + delaunay::grid_kernel::limbs::product(c, d);
+		REQUIRE(sum.positive() == (static_cast<__int128>(a) * b + static_cast<__int128>(c) * d > 0));
+	}
+
+	REQUIRE(!(delaunay::grid_kernel::limbs::product(3, -5) + delaunay::grid_kernel::limbs::product(5, 3)).positive());
+#endif
+
+	std::vector<point> fraction = { point(0, 0), point(1, 0), point(0.5, 1) };
+	REQUIRE_THROWS_AS(delaunay::triangulate_with<delaunay::grid_kernel>(fraction, indices, hull),
+	                  std::invalid_argument);
+
+	std::vector<point> far = { point(0, 0), point(1 << 27, 0), point(0, 1) };
+	REQUIRE_THROWS_AS(delaunay::triangulate_with<delaunay::grid_kernel>(far, indices, hull),
+	                  std::invalid_argument);
+}
+
+TEST_CASE("Weighted points form a regular triangulation", "[regular]") {
+	std::vector<point> points = generate_points(400, 10);
+
+	// Equal weights shift every power circle alike
+	std::vector<double> equal(points.size(), 2.5);
+	std::vector<uint32_t> hidden;
+	mesh m = delaunay::triangulate_regular(points, equal, &hidden);
+	REQUIRE(hidden.empty());
+	REQUIRE(m.size() == delaunay::triangulate(points).size());
+
+	std::mt19937 gen(7);
+	std::uniform_real_distribution<> dist(0.0, 0.5);
+
+	std::vector<double> weights(points.size());
+	for(double& w : weights) w = dist(gen);
+
+	// A light point in the middle of heavy ones is hidden
+	points.emplace_back(0.0, 0.0);
+	weights.push_back(-100.0);
+
+	m = delaunay::triangulate_regular(points, weights, &hidden);
+	REQUIRE(std::find(hidden.begin(), hidden.end(), points.size() - 1) != hidden.end());
+
+	// No point, hidden or not, lies below the plane of any lifted triangle.
+	// Evaluating power() rounds to the magnitude of the squared radius, and
+	// flat hull triangles have power circles of 1e7 and more, where even a
+	// triangle's own vertices land a few ulp below their weight
+	bool regular = true;
+	for(size_t t = 0; t < m.size(); ++t) {
+		const uint32_t* v = &m.indices[3 * t];
+		circle power = m.at(t).power_circle(weights[v[0]], weights[v[1]], weights[v[2]]);
+
+		for(size_t i = 0; i < points.size(); ++i) {
+			regular &= power.power(points[i]) - weights[i] > -1e-9 * (1.0 + std::fabs(power.radius));
+		}
+	}
+
+	REQUIRE(regular);
+
+	REQUIRE(m.hull.size() == static_cast<size_t>(std::count(m.neighbors.begin(), m.neighbors.end(), mesh::none)));
+	REQUIRE_THROWS(delaunay::triangulate_regular(points, std::vector<double>(3, 0.0)));
+}
+
+TEST_CASE("Power cells partition the clipping box", "[power]") {
+	std::vector<point> points = generate_points(300, 10);
+
+	std::mt19937 gen(11);
+	std::uniform_real_distribution<> dist(0.0, 2.0);
+
+	std::vector<double> weights(points.size());
+	for(double& w : weights) w = dist(gen);
+
+	mesh m = delaunay::triangulate_regular(points, weights);
+	point min(-8, -6), max(12, 7);
+	delaunay::power_diagram diagram = delaunay::power_cells(m, weights, min, max);
+
+	REQUIRE(diagram.size() == points.size());
+
+	auto area = [](const std::vector<point>& cell) {
+		double sum = 0.0;
+		for(size_t i = 0; i < cell.size(); ++i) {
+			const point& p = cell[i];
+			const point& q = cell[(i + 1) % cell.size()];
+			sum += p.x * q.y - q.x * p.y;
+		}
+
+		return sum / 2.0;
+	};
+
+	double total = 0.0;
+	for(size_t v = 0; v < diagram.size(); ++v) {
+		double a = area(diagram.cell(v));
+		REQUIRE(a >= 0.0);
+		total += a;
+	}
+
+	REQUIRE(std::fabs(total - 20.0 * 13.0) < 1e-6);
+
+	// Every sample lies in the cell of the site it has the least power to
+	std::uniform_real_distribution<> x(min.x, max.x), y(min.y, max.y);
+	for(int sample = 0; sample < 200; ++sample) {
+		point q(x(gen), y(gen));
+
+		size_t owner = 0;
+		for(size_t v = 0; v < points.size(); ++v) {
+			if(q.distance_squared(points[v]) - weights[v] < q.distance_squared(points[owner]) - weights[owner]) owner = v;
+		}
+
+		std::vector<point> cell = diagram.cell(owner);
+		bool inside = !cell.empty();
+		for(size_t i = 0; i < cell.size(); ++i) {
+			const point& a = cell[i];
+			const point& b = cell[(i + 1) % cell.size()];
+			inside &= (b.x - a.x) * (q.y - a.y) - (q.x - a.x) * (b.y - a.y) >= -1e-9;
+		}
+
+		REQUIRE(inside);
+	}
+}
+
+TEST_CASE("Lloyd relaxation spreads points evenly", "[lloyd]") {
+	std::vector<point> points = generate_points(400, 10);
+	mesh m = delaunay::triangulate_mesh(points);
+
+	auto shortest_edge = [](const mesh& m) {
+		double shortest = INFINITY;
+		for(size_t slot = 0; slot < m.indices.size(); ++slot) {
+			const point& a = m.vertices[m.indices[slot]];
+			const point& b = m.vertices[m.indices[slot - slot % 3 + (slot + 1) % 3]];
+			shortest = std::min(shortest, a.distance_squared(b));
+		}
+
+		return shortest;
+	};
+
+	double before = shortest_edge(m);
+	size_t iterations = delaunay::relax(m, point(-10, -10), point(10, 10), delaunay::relaxation(200, 1e-3));
+
+	REQUIRE(iterations > 1);
+	REQUIRE(iterations < 200);
+	REQUIRE(shortest_edge(m) > 10 * before);
+
+	// The repaired mesh is still the Delaunay triangulation of its vertices
+	REQUIRE(m.size() == delaunay::triangulate(m.vertices).size());
+	for(size_t t = 0; t < m.size(); ++t) {
+		circle c = m.at(t).circumcircle();
+
+		bool empty = true;
+		for(const point& p : m.vertices) empty &= !c.contains(p);
+		REQUIRE(empty);
+	}
+}
+
+TEST_CASE("Alpha complexes answer every alpha", "[alpha]") {
+	std::vector<point> points = generate_points(2000, 10);
+	mesh m = delaunay::triangulate_mesh(points);
+	delaunay::alpha_complex complex(m);
+
+	REQUIRE(complex.triangle_count(-1.0) == 0);
+	REQUIRE(complex.triangle_count(INFINITY) == m.size());
+	REQUIRE(complex.edge_count(INFINITY) == (3 * m.size() + m.hull.size()) / 2);
+
+	auto area = [&](uint32_t a, uint32_t b, uint32_t c) {
+		const point& p = m.vertices[a];
+		const point& q = m.vertices[b];
+		const point& r = m.vertices[c];
+		return ((q.x - p.x) * (r.y - p.y) - (r.x - p.x) * (q.y - p.y)) / 2.0;
+	};
+
+	for(double alpha : { 0.01, 0.05, 0.2, 1.0 }) {
+		std::vector<uint32_t> triangles = complex.triangles(alpha);
+
+		double inside = 0.0;
+		for(uint32_t t : triangles) {
+			REQUIRE(m.at(t).circumcircle().radius <= alpha);
+			inside += area(m.indices[3 * t], m.indices[3 * t + 1], m.indices[3 * t + 2]);
+		}
+
+		size_t expected = 0;
+		for(size_t t = 0; t < m.size(); ++t) expected += m.at(t).circumcircle().radius <= alpha;
+		REQUIRE(triangles.size() == expected);
+
+		// The rings enclose exactly the triangles of the complex
+		double enclosed = 0.0;
+		for(const std::vector<uint32_t>& ring : complex.polylines(alpha)) {
+			REQUIRE(ring.size() >= 3);
+			for(size_t i = 1; i + 1 < ring.size(); ++i) enclosed += area(ring[0], ring[i], ring[i + 1]);
+		}
+
+		REQUIRE(std::fabs(enclosed - inside) < 1e-9 * (1.0 + inside));
+	}
+
+	std::vector<std::vector<uint32_t>> outline = complex.polylines(INFINITY);
+	REQUIRE(outline.size() == 1);
+	REQUIRE(outline[0].size() == m.hull.size());
+}
+
+TEST_CASE("Spanning trees and Gabriel graphs come from the mesh edges", "[graph]") {
+	std::vector<point> points = generate_points(500, 10);
+	mesh m = delaunay::triangulate_mesh(points);
+
+	std::vector<uint32_t> edges = delaunay::unique_edges(m);
+	REQUIRE(edges.size() == 3 * m.size() + m.hull.size());
+
+	std::vector<std::pair<uint32_t, uint32_t>> pairs;
+	for(size_t i = 0; i < edges.size(); i += 2) pairs.emplace_back(std::minmax(edges[i], edges[i + 1]));
+	std::sort(pairs.begin(), pairs.end());
+	REQUIRE(std::adjacent_find(pairs.begin(), pairs.end()) == pairs.end());
+
+	// Prim's algorithm over the complete graph
+	std::vector<double> distance(points.size(), INFINITY);
+	std::vector<uint8_t> reached(points.size(), 0);
+	double expected = 0.0;
+
+	distance[0] = 0.0;
+	for(size_t step = 0; step < points.size(); ++step) {
+		size_t v = 0;
+		while(reached[v]) ++v;
+		for(size_t w = v; w < points.size(); ++w) {
+			if(!reached[w] && distance[w] < distance[v]) v = w;
+		}
+
+		reached[v] = 1;
+		expected += std::sqrt(distance[v]);
+
+		for(size_t w = 0; w < points.size(); ++w) {
+			distance[w] = std::min(distance[w], points[v].distance_squared(points[w]));
+		}
+	}
+
+	std::vector<uint32_t> tree = delaunay::minimum_spanning_tree(m, 4);
+	REQUIRE(tree.size() == 2 * (points.size() - 1));
+
+	double total = 0.0;
+	for(size_t i = 0; i < tree.size(); i += 2) total += std::sqrt(points[tree[i]].distance_squared(points[tree[i + 1]]));
+	REQUIRE(std::fabs(total - expected) < 1e-9 * expected);
+
+	std::vector<uint32_t> gabriel = delaunay::gabriel_graph(m);
+	std::vector<std::pair<uint32_t, uint32_t>> gabriel_pairs;
+
+	for(size_t i = 0; i < gabriel.size(); i += 2) {
+		const point& a = points[gabriel[i]];
+		const point& b = points[gabriel[i + 1]];
+		point middle = point::midpoint(a, b);
+
+		bool empty = true;
+		for(const point& p : points) empty &= p.distance_squared(middle) >= a.distance_squared(b) / 4.0 - 1e-12;
+		REQUIRE(empty);
+
+		gabriel_pairs.emplace_back(std::minmax(gabriel[i], gabriel[i + 1]));
+	}
+
+	std::sort(gabriel_pairs.begin(), gabriel_pairs.end());
+	for(size_t i = 0; i < tree.size(); i += 2) {
+		REQUIRE(std::binary_search(gabriel_pairs.begin(), gabriel_pairs.end(),
+		                           std::pair<uint32_t, uint32_t>(std::minmax(tree[i], tree[i + 1]))));
+	}
+}
+
+TEST_CASE("Adjacency lists run counter-clockwise around every vertex", "[graph]") {
+	std::vector<point> points = generate_points(1000, 10);
+	mesh m = delaunay::triangulate_mesh(points);
+
+	delaunay::adjacency graph = delaunay::vertex_adjacency(m, 3);
+	REQUIRE(graph.size() == points.size());
+	REQUIRE(graph.neighbors.size() == delaunay::unique_edges(m).size());
+	REQUIRE(graph.neighbors == delaunay::vertex_adjacency(m, 1).neighbors);
+
+	std::vector<uint8_t> on_hull(points.size(), 0);
+	for(uint32_t v : m.hull) on_hull[v] = 1;
+
+	for(size_t v = 0; v < graph.size(); ++v) {
+		const uint32_t* around = &graph.neighbors[graph.offsets[v]];
+		size_t degree = graph.degree(v);
+		REQUIRE(degree >= 2);
+
+		// Consecutive neighbors turn left, once around (or less, on the hull)
+		double turned = 0.0;
+		for(size_t i = 0; i + on_hull[v] < degree; ++i) {
+			const point& a = points[around[i]];
+			const point& b = points[around[(i + 1) % degree]];
+			double ax = a.x - points[v].x, ay = a.y - points[v].y;
+			double bx = b.x - points[v].x, by = b.y - points[v].y;
+
+			REQUIRE(ax * by - ay * bx > 0.0);
+			turned += std::atan2(ax * by - ay * bx, ax * bx + ay * by);
+		}
+
+		if(on_hull[v]) {
+			REQUIRE(turned < M_PI);
+		} else {
+			REQUIRE(std::fabs(turned - 2 * M_PI) < 1e-9);
+		}
+
+		// Every neighbor lists v back
+		for(size_t i = 0; i < degree; ++i) {
+			const uint32_t* back = &graph.neighbors[graph.offsets[around[i]]];
+			REQUIRE(std::count(back, back + graph.degree(around[i]), v) == 1);
+		}
+	}
+
+	// Two cells of a masked raster meeting only at the middle node pinch
+	// it, and both fans around it are listed
+	std::vector<uint8_t> mask = { 1, 0, 0, 1, 1, 1, 0, 0, 1 };
+	mesh pinched = delaunay::triangulate_raster(delaunay::raster(3, 3), mask);
+	REQUIRE(pinched.size() == 2);
+
+	delaunay::adjacency fans = delaunay::vertex_adjacency(pinched);
+	REQUIRE(fans.neighbors.size() == delaunay::unique_edges(pinched).size());
+	REQUIRE(fans.degree(2) == 4);
+
+	std::vector<uint32_t> middle(&fans.neighbors[fans.offsets[2]], &fans.neighbors[fans.offsets[3]]);
+	std::sort(middle.begin(), middle.end());
+	REQUIRE(middle == std::vector<uint32_t>{ 0, 1, 3, 4 });
+}
+
+TEST_CASE("Reordered meshes keep their triangles and gain locality", "[reorder]") {
+	std::vector<point> points = generate_points(3000, 10);
+	const mesh original = delaunay::triangulate_mesh(points);
+
+	// Misses of a FIFO vertex cache per triangle
+	auto misses = [](const mesh& m) {
+		std::vector<uint32_t> fifo;
+		size_t count = 0;
+
+		for(uint32_t v : m.indices) {
+			if(std::find(fifo.begin(), fifo.end(), v) != fifo.end()) continue;
+
+			++count;
+			fifo.insert(fifo.begin(), v);
+			if(fifo.size() > 16) fifo.pop_back();
+		}
+
+		return double(count) / m.size();
+	};
+
+	auto check = [&](const mesh& m, const delaunay::reordering& order) {
+		REQUIRE(order.vertices.size() == original.vertices.size());
+		REQUIRE(order.triangles.size() == original.size());
+
+		for(size_t v = 0; v < m.vertices.size(); ++v) REQUIRE(m.vertices[v] == original.vertices[order.vertices[v]]);
+		for(size_t t = 0; t < m.size(); ++t) REQUIRE(m.at(t) == original.at(order.triangles[t]));
+
+		mesh connected = m;
+		connected.connect();
+		REQUIRE(connected.neighbors == m.neighbors);
+
+		mesh traced = m;
+		traced.trace_hull();
+		REQUIRE(traced.hull.size() == m.hull.size());
+		REQUIRE(std::is_permutation(traced.hull.begin(), traced.hull.end(), m.hull.begin()));
+	};
+
+	mesh hilbert = original;
+	check(hilbert, delaunay::reorder_hilbert(hilbert));
+	REQUIRE(misses(hilbert) < misses(original));
+
+	mesh cached = original;
+	check(cached, delaunay::reorder_vertex_cache(cached));
+	REQUIRE(misses(cached) < misses(hilbert));
+}
+
+TEST_CASE("Parallel sorts match sequential sorts", "[parallel]") {
+	std::mt19937 gen(3);
+	std::vector<uint32_t> values(200000);
+	for(uint32_t& v : values) v = gen() % 1000;
+
+	std::vector<uint32_t> sorted = values;
+	std::sort(sorted.begin(), sorted.end());
+
+	delaunay::parallel_sort(values.begin(), values.end(), std::less<uint32_t>(), 5);
+	REQUIRE(values == sorted);
+}
+
+TEST_CASE("Radix sorts are stable", "[parallel]") {
+	std::mt19937_64 gen(4);
+	std::vector<uint64_t> keys(100000);
+	std::vector<uint32_t> values(keys.size());
+
+	// Few distinct keys, spread over every byte
+	for(size_t i = 0; i < keys.size(); ++i) {
+		keys[i] = (gen() % 50) * 0x0101010101010101ull;
+		values[i] = static_cast<uint32_t>(i);
+	}
+
+	std::vector<std::pair<uint64_t, uint32_t>> pairs;
+	for(size_t i = 0; i < keys.size(); ++i) pairs.emplace_back(keys[i], values[i]);
+	std::sort(pairs.begin(), pairs.end());
+
+	delaunay::radix_sort(keys, values, 3);
+	for(size_t i = 0; i < keys.size(); ++i) REQUIRE(std::make_pair(keys[i], values[i]) == pairs[i]);
+
+	std::vector<double> doubles = { -1e300, -2.5, -1.0, -1e-300, 0.0, 1e-300, 1.0, 2.5, 1e300 };
+	for(size_t i = 1; i < doubles.size(); ++i) {
+		REQUIRE(delaunay::radix_key(doubles[i - 1]) < delaunay::radix_key(doubles[i]));
+	}
+
+	REQUIRE(delaunay::radix_key(-0.0) == delaunay::radix_key(0.0));
+}
+
+TEST_CASE("Parallel loops run on a custom executor", "[parallel]") {
+	std::vector<std::thread> threads;
+	std::vector<std::function<void()>> late;
+
+	auto check = [](unsigned workers) {
+		std::vector<std::atomic<int>> visits(5000);
+		for(std::atomic<int>& v : visits) v = 0;
+
+		// All the work sits at the front
+		std::atomic<size_t> sum(0);
+		delaunay::parallel_for(visits.size(), workers, [&](size_t i) {
+			size_t work = i < 100 ? 2000 : 1;
+			for(size_t k = 0; k < work; ++k) sum += k & 1;
+			++visits[i];
+		});
+
+		bool once = true;
+		for(std::atomic<int>& v : visits) once &= v == 1;
+		REQUIRE(once);
+	};
+
+	delaunay::set_executor([&](std::function<void()> task) {
+		threads.emplace_back(std::move(task));
+	});
+
+	check(4);
+	REQUIRE(threads.size() == 3);
+	for(std::thread& t : threads) t.join();
+
+	// Tasks that never start before the loop ends leave it to the caller
+	delaunay::set_executor([&](std::function<void()> task) {
+		late.push_back(std::move(task));
+	});
+
+	check(4);
+	REQUIRE(late.size() == 3);
+	for(std::function<void()>& task : late) task();
+
+	delaunay::set_executor(delaunay::executor());
+	check(4);
+
+	REQUIRE_THROWS_AS(delaunay::parallel_for(100, 4, [](size_t i) {
+		if(i == 50) throw std::runtime_error("failed");
+	}), std::runtime_error);
+}
+
+TEST_CASE("Meshes answer point queries", "[locate]") {
+	std::vector<point> points = generate_points(1000, 10);
+	mesh m = delaunay::triangulate_mesh(points);
+
+	// A linear function is interpolated exactly
+	std::vector<double> heights(points.size());
+	for(size_t v = 0; v < points.size(); ++v) heights[v] = 2.0 * points[v].x - 3.0 * points[v].y + 1.0;
+
+	std::mt19937 gen(5);
+	std::uniform_real_distribution<> dist(-12.0, 12.0);
+
+	uint32_t hint = 0;
+	for(int query = 0; query < 500; ++query) {
+		point q(dist(gen), dist(gen));
+
+		bool inside = true;
+		for(size_t i = 0; i < m.hull.size(); ++i) {
+			const point& a = points[m.hull[i]];
+			const point& b = points[m.hull[(i + 1) % m.hull.size()]];
+			inside &= (b.x - a.x) * (q.y - a.y) - (q.x - a.x) * (b.y - a.y) >= 0.0;
+		}
+
+		uint32_t t = delaunay::locate(m, q, hint);
+		REQUIRE((t != mesh::none) == inside);
+
+		if(inside) {
+			hint = t;
+
+			double height = delaunay::interpolate(m, heights, q, hint);
+			REQUIRE(std::fabs(height - (2.0 * q.x - 3.0 * q.y + 1.0)) < 1e-9);
+		} else {
+			REQUIRE(std::isnan(delaunay::interpolate(m, heights, q, hint)));
+		}
+
+		size_t closest = 0;
+		for(size_t v = 1; v < points.size(); ++v) {
+			if(points[v].distance_squared(q) < points[closest].distance_squared(q)) closest = v;
+		}
+
+		REQUIRE(delaunay::nearest_vertex(m, q, hint) == closest);
+	}
+}
+
+TEST_CASE("Points are inserted into a mesh", "[locate]") {
+	std::vector<point> points = generate_points(100, 5);
+	mesh m = delaunay::triangulate_mesh(points);
+
+	// Inside and outside the hull, and repeated
+	std::vector<point> more = generate_points(300, 8);
+	more.push_back(points[7]);
+
+	for(const point& p : more) delaunay::insert(m, p, static_cast<uint32_t>(m.size() - 1));
+
+	REQUIRE(m.vertices.size() == points.size() + more.size() - 1);
+	REQUIRE(m.size() == delaunay::triangulate(m.vertices).size());
+
+	for(size_t t = 0; t < m.size(); ++t) {
+		circle c = m.at(t).circumcircle();
+
+		bool empty = true;
+		for(const point& p : m.vertices) empty &= !c.contains(p);
+		REQUIRE(empty);
+	}
+
+	mesh connected = m;
+	connected.connect();
+	REQUIRE(connected.neighbors == m.neighbors);
+
+	std::vector<uint32_t> hull = delaunay::convex_hull(m.vertices);
+	REQUIRE(std::is_permutation(hull.begin(), hull.end(), m.hull.begin(), m.hull.end()));
+}
+
+TEST_CASE("Batches of points are inserted in parallel", "[locate]") {
+	std::vector<point> points = generate_points(200, 5);
+	mesh m = delaunay::triangulate_mesh(points);
+
+	std::vector<point> more = generate_points(2000, 6);
+	more.push_back(points[3]);
+	more.push_back(more[10]);
+
+	mesh serial = m, threaded = m;
+	std::vector<uint32_t> vertices = delaunay::insert(serial, more, 1);
+
+	// The same mesh for any number of threads
+	REQUIRE(delaunay::insert(threaded, more, 4) == vertices);
+	REQUIRE(threaded.indices == serial.indices);
+	REQUIRE(threaded.neighbors == serial.neighbors);
+
+	// Repeated points map to the vertex already there
+	REQUIRE(serial.vertices.size() == points.size() + more.size() - 2);
+	REQUIRE(vertices[more.size() - 2] == 3);
+	REQUIRE(vertices.back() == vertices[10]);
+
+	for(size_t i = 0; i < more.size(); ++i) REQUIRE(serial.vertices[vertices[i]] == more[i]);
+
+	REQUIRE(serial.size() == delaunay::triangulate(serial.vertices).size());
+
+	for(size_t t = 0; t < serial.size(); ++t) {
+		circle c = serial.at(t).circumcircle();
+
+		bool empty = true;
+		for(const point& p : serial.vertices) empty &= !c.contains(p);
+		REQUIRE(empty);
+	}
+
+	mesh connected = serial;
+	connected.connect();
+	REQUIRE(connected.neighbors == serial.neighbors);
+
+	std::vector<uint32_t> hull = delaunay::convex_hull(serial.vertices);
+	REQUIRE(std::is_permutation(hull.begin(), hull.end(), serial.hull.begin(), serial.hull.end()));
+}
+
+TEST_CASE("Readers keep their version while points are inserted", "[concurrent]") {
+	delaunay::concurrent_mesh shared(delaunay::triangulate_mesh(generate_points(200, 10)), 8);
+	std::atomic<bool> done(false);
+	std::atomic<size_t> failures(0), reads(0);
+
+	std::vector<std::thread> readers;
+	for(int r = 0; r < 3; ++r) {
+		readers.emplace_back([&, r]() {
+			std::mt19937 gen(r);
+			std::uniform_real_distribution<> dist(-10.0, 10.0);
+
+			while(!done || reads < 100) {
+				delaunay::concurrent_mesh::reader version = shared.read();
+				size_t triangles = version->size();
+
+				for(int query = 0; query < 20; ++query) {
+					point q(dist(gen), dist(gen));
+					uint32_t t = delaunay::locate(*version, q);
+					if(t != mesh::none && t >= triangles) ++failures;
+				}
+
+				// The pinned version never changes underneath
+				if(version->size() != triangles || version->indices.size() != 3 * triangles) ++failures;
+				++reads;
+			}
+		});
+	}
+
+	for(int batch = 0; batch < 20; ++batch) shared.insert(generate_points(20, 10));
+	done = true;
+
+	for(std::thread& t : readers) t.join();
+
+	REQUIRE(failures == 0);
+	REQUIRE(shared.version() == 21);
+
+	delaunay::concurrent_mesh::reader last = shared.read();
+	REQUIRE(last->vertices.size() == 600);
+	REQUIRE(last->size() == delaunay::triangulate(last->vertices).size());
+}
+
+TEST_CASE("Statistics account for every triangle", "[statistics]") {
+	std::vector<point> points = generate_points(500, 10);
+
+	delaunay::statistics stats;
+	std::vector<triangle> triangulation = delaunay::triangulate(points, stats);
+
+	uint64_t cavities = 0;
+	for(uint64_t count : stats.cavity_sizes) cavities += count;
+
+	if(delaunay::statistics::enabled) {
+		REQUIRE(stats.points == points.size());
+		REQUIRE(cavities == points.size());
+		REQUIRE(stats.triangles_created - stats.triangles_destroyed == triangulation.size());
+		REQUIRE(stats.incircle_tests + stats.halfplane_tests > 0);
+		REQUIRE(stats.allocations > 0);
+	} else {
+		REQUIRE(stats.points == 0);
+		REQUIRE(cavities == 0);
+		REQUIRE(stats.incircle_tests == 0);
+	}
+
+	// Empty cavities on their own, then one bucket per power of two
+	delaunay::statistics sizes;
+	for(size_t size : { 0, 1, 2, 3, 4, 7, 8 }) sizes.cavity(size);
+	sizes.cavity(size_t(1) << 40);
+
+	REQUIRE(sizes.cavity_sizes[0] == 1);
+	REQUIRE(sizes.cavity_sizes[1] == 1);
+	REQUIRE(sizes.cavity_sizes[2] == 2);
+	REQUIRE(sizes.cavity_sizes[3] == 2);
+	REQUIRE(sizes.cavity_sizes[4] == 1);
+	REQUIRE(sizes.cavity_sizes[delaunay::statistics::buckets - 1] == 1);
+}
+
+TEST_CASE("Triangulators reuse their buffers", "[triangulator]") {
+	std::vector<std::vector<point>> inputs;
+	for(int n : { 500, 50, 300, 120 }) inputs.push_back(generate_points(n, 10));
+
+	// Lines, circles and grids, which skip the general engine
+	std::vector<point> line, ring, grid;
+	for(int i = 0; i < 40; ++i) line.emplace_back(i, 2 * i);
+	for(int i = 0; i < 60; ++i) ring.emplace_back(std::cos(i * M_PI / 30), std::sin(i * M_PI / 30));
+	for(int i = 0; i < 100; ++i) grid.emplace_back(i % 10, i / 10);
+
+	REQUIRE(delaunay::classify(line) == delaunay::degeneracy::collinear);
+	REQUIRE(delaunay::classify(ring) == delaunay::degeneracy::cocircular);
+	REQUIRE(delaunay::classify(grid) == delaunay::degeneracy::grid);
+	inputs.insert(inputs.begin() + 2, { line, ring, grid });
+
+	// The first inputs grow the buffers, which the counter sees
+	delaunay::triangulator context;
+	size_t cold = heap_allocations;
+	for(const std::vector<point>& points : inputs) {
+		REQUIRE(context.triangulate(points) == delaunay::triangulate(points));
+	}
+
+	REQUIRE(heap_allocations > cold);
+
+	// Every buffer has grown to fit every input by now
+	const triangle* triangles = context.triangles.data();
+	const uint32_t* indices = context.indices.data();
+	const uint32_t* hull = context.hull.data();
+
+	for(const std::vector<point>& points : inputs) {
+		delaunay::statistics stats;
+
+		size_t before = heap_allocations;
+		const std::vector<triangle>& result = context.triangulate(points, &stats);
+		REQUIRE(heap_allocations == before);
+		REQUIRE(stats.allocations == 0);
+
+		REQUIRE(result == delaunay::triangulate(points));
+
+		REQUIRE(context.triangles.data() == triangles);
+		REQUIRE(context.indices.data() == indices);
+		REQUIRE(context.hull.data() == hull);
+	}
+}
+
+TEST_CASE("Triangulators are faster on small inputs", "[.benchmark]") {
+	std::vector<point> points = generate_points(200, 10);
+	delaunay::triangulator context;
+
+	BENCHMARK("triangulate") {
+		return delaunay::triangulate(points).size();
+	};
+
+	BENCHMARK("triangulator") {
+		return context.triangulate(points).size();
+	};
+}
+
+TEST_CASE("Duplicate points are merged before triangulating", "[dedup]") {
+	std::vector<point> unique = generate_points(500, 10);
+
+	// Every third point repeats exactly, every fifth nearly
+	std::vector<point> points = unique;
+	for(size_t i = 0; i < unique.size(); i += 3) points.push_back(unique[i]);
+	for(size_t i = 0; i < unique.size(); i += 5) points.emplace_back(unique[i].x + 1e-9, unique[i].y);
+
+	delaunay::deduplication exact = delaunay::deduplicate(points);
+	REQUIRE(exact.representative.size() == points.size());
+	REQUIRE(exact.points.size() == unique.size() + (unique.size() + 4) / 5);
+
+	delaunay::deduplication near = delaunay::deduplicate(points, 1e-6);
+	REQUIRE(near.points == unique);
+
+	for(size_t i = 0; i < points.size(); ++i) {
+		REQUIRE(near.points[near.representative[i]].distance_squared(points[i]) <= 1e-12);
+		REQUIRE(exact.points[exact.representative[i]].x == points[i].x);
+	}
+
+	// The unique set triangulates like the original points
+	REQUIRE(delaunay::triangulate(near.points).size() == delaunay::triangulate(unique).size());
+	REQUIRE_THROWS(delaunay::deduplicate(points, -1.0));
+
+	// A pile of near-duplicates joins its first point, and a point just out
+	// of its reach stays distinct
+	std::mt19937 gen(35);
+	std::uniform_real_distribution<double> jitter(-0.3, 0.3);
+	std::vector<point> pile = { point(5, 5) };
+	for(int i = 0; i < 20000; ++i) pile.emplace_back(5 + jitter(gen), 5 + jitter(gen));
+	pile.emplace_back(6.1, 5);
+
+	delaunay::deduplication piled = delaunay::deduplicate(pile, 1.0);
+	REQUIRE(piled.points == std::vector<point>{ point(5, 5), point(6.1, 5) });
+}
+
+TEST_CASE("Installed tracers record triangulation phases", "[trace]") {
+	std::vector<point> points = generate_points(3000, 10);
+
+	delaunay::tracer tracer;
+	delaunay::tracer::install(&tracer);
+	delaunay::triangulate(points);
+	delaunay::tracer::install(nullptr);
+
+	// The whole run, three insertion batches, the cleanup and the output
+	REQUIRE(tracer.size() == 6);
+
+	delaunay::triangulate(points);
+	REQUIRE(tracer.size() == 6);
+
+	// The batches are part of the whole run
+	REQUIRE(tracer.seconds("insert") > 0.0);
+	REQUIRE(tracer.seconds("insert") <= tracer.seconds("triangulate"));
+	REQUIRE(tracer.seconds("load") == 0.0);
+
+	std::string path = (std::filesystem::temp_directory_path() / "delaunay-test.json").string();
+	tracer.write(path);
+
+	std::ifstream in(path);
+	std::string json((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	REQUIRE(json.find("\"traceEvents\"") != std::string::npos);
+	REQUIRE(json.find("\"name\":\"cleanup\"") != std::string::npos);
+
+	std::filesystem::remove(path);
+}
+
+TEST_CASE("Meshes index triangles and their neighbors", "[mesh]") {
+	std::vector<point> points = generate_points(500, 10);
+	mesh m = delaunay::triangulate_mesh(points);
+
+	REQUIRE(m.size() == delaunay::triangulate(points).size());
+	REQUIRE(m.neighbors.size() == m.indices.size());
+
+	for(size_t t = 0; t < m.size(); ++t) {
+		for(size_t i = 0; i < 3; ++i) {
+			uint32_t n = m.neighbors[3 * t + i];
+			if(n == mesh::none) continue;
+
+			// Neighbors point back at each other across the same edge
+			bool mutual = false;
+			for(size_t j = 0; j < 3; ++j) {
+				mutual |= m.neighbors[3 * n + j] == t &&
+					m.indices[3 * n + j] == m.indices[3 * t + (i + 1) % 3] &&
+					m.indices[3 * n + (j + 1) % 3] == m.indices[3 * t + i];
+			}
+
+			REQUIRE(mutual);
+		}
+	}
+}
+
+TEST_CASE("Mesh hulls run counter-clockwise along the boundary", "[mesh]") {
+	std::vector<point> points = generate_points(500, 10);
+	mesh m = delaunay::triangulate_mesh(points);
+
+	size_t boundary = std::count(m.neighbors.begin(), m.neighbors.end(), mesh::none);
+	REQUIRE(m.hull.size() == boundary);
+
+	for(size_t i = 0; i < m.hull.size(); ++i) {
+		const point& a = m.vertices[m.hull[i]];
+		const point& b = m.vertices[m.hull[(i + 1) % m.hull.size()]];
+
+		// Every other point lies to the left of a hull edge
+		for(const point& p : points) {
+			REQUIRE((b.x - a.x) * (p.y - a.y) - (p.x - a.x) * (b.y - a.y) >= 0.0);
+		}
+	}
+
+	// Meshes built from triangles trace the same ring
+	mesh rebuilt(points, delaunay::triangulate(points));
+	REQUIRE(rebuilt.hull.size() == m.hull.size());
+	REQUIRE(std::is_permutation(rebuilt.hull.begin(), rebuilt.hull.end(), m.hull.begin()));
+}
+
+TEST_CASE("Convex hulls match the triangulation hull", "[hull]") {
+	std::vector<point> points = generate_points(2000, 10);
+	mesh m = delaunay::triangulate_mesh(points);
+	std::vector<uint32_t> hull = delaunay::convex_hull(points);
+
+	// Same ring, up to its starting vertex
+	REQUIRE(hull.size() == m.hull.size());
+	auto start = std::find(m.hull.begin(), m.hull.end(), hull[0]);
+	REQUIRE(start != m.hull.end());
+	std::rotate(m.hull.begin(), start, m.hull.end());
+	REQUIRE(hull == m.hull);
+
+	// Collinear and repeated points collapse to the two ends
+	std::vector<point> line = { point(2, 2), point(0, 0), point(1, 1), point(2, 2), point(3, 3) };
+	REQUIRE(delaunay::convex_hull(line) == std::vector<uint32_t>{ 1, 4 });
+	REQUIRE(delaunay::convex_hull({}).empty());
+
+	// A single distinct point is its own hull, once
+	std::vector<point> same(5, point(4, 2));
+	REQUIRE(delaunay::convex_hull(same) == std::vector<uint32_t>{ 0 });
+	REQUIRE(delaunay::convex_hull({ point(4, 2) }) == std::vector<uint32_t>{ 0 });
+}
+
+TEST_CASE("Saved meshes are mapped back unchanged", "[mesh]") {
+	mesh m = delaunay::triangulate_mesh(generate_points(500, 10));
+
+	std::string path = (std::filesystem::temp_directory_path() / "delaunay-test.mesh").string();
+	m.save(path);
+
+	{
+		mapped_mesh mapped(path);
+
+		REQUIRE(mapped.vertex_count == m.vertices.size());
+		REQUIRE(mapped.size() == m.size());
+		REQUIRE(std::equal(m.indices.begin(), m.indices.end(), mapped.indices));
+		REQUIRE(std::equal(m.neighbors.begin(), m.neighbors.end(), mapped.neighbors));
+		REQUIRE(mapped.hull_count == m.hull.size());
+		REQUIRE(std::equal(m.hull.begin(), m.hull.end(), mapped.hull));
+		REQUIRE(mapped.at(0) == m.at(0));
+	}
+
+	// Rewrite part of the saved file and expect it to be rejected
+	auto tamper = [&](size_t offset, const void* bytes, size_t size) {
+		std::string damaged = path + ".damaged";
+		std::filesystem::copy_file(path, damaged, std::filesystem::copy_options::overwrite_existing);
+
+		std::fstream file(damaged, std::ios::binary | std::ios::in | std::ios::out);
+		file.seekp(offset);
+		file.write(static_cast<const char*>(bytes), size);
+		file.close();
+
+		REQUIRE_THROWS_AS(mapped_mesh(damaged), std::runtime_error);
+		std::filesystem::remove(damaged);
+	};
+
+	// A vertex count whose byte size wraps around to a small number
+	uint64_t wrapping = uint64_t(1) << 60;
+	tamper(8, &wrapping, sizeof(wrapping));
+
+	// Only the current version is read
+	uint32_t old_version = 1;
+	tamper(4, &old_version, sizeof(old_version));
+
+	uint32_t outside = static_cast<uint32_t>(m.vertices.size());
+	tamper(32 + m.vertices.size() * sizeof(point), &outside, sizeof(outside));
+
+	std::filesystem::remove(path);
+}
+
+TEST_CASE("Streamed triangulations match batch triangulations", "[stream]") {
+	std::vector<point> points = generate_points(2000, 100);
+	std::sort(points.begin(), points.end(), [](const point& a, const point& b) {
+		return a.x < b.x;
+	});
+
+	std::vector<triangle> streamed;
+	delaunay::streaming_triangulator stream([&](const triangle& t) {
+		streamed.push_back(t);
+	});
+
+	size_t peak = 0;
+	for(size_t i = 0; i < points.size(); i += 100) {
+		std::vector<point> chunk(points.begin() + i, points.begin() + std::min(i + 100, points.size()));
+		stream.insert(chunk);
+
+		peak = std::max(peak, stream.active());
+		if(i + 100 < points.size()) stream.finalize(points[i + 100].x);
+	}
+
+	stream.finish();
+
+	std::vector<triangle> batch = delaunay::triangulate(points);
+	REQUIRE(streamed.size() == batch.size());
+	for(const triangle& t : streamed) {
+		REQUIRE(std::find_if(batch.begin(), batch.end(), [&](const triangle& b) {
+			return b.has_vertex(t.a) && b.has_vertex(t.b) && b.has_vertex(t.c);
+		}) != batch.end());
+	}
+
+	// Only the front is kept in memory
+	REQUIRE(peak < batch.size());
+	REQUIRE_THROWS(stream.insert({ point(0, 0) }));
+}
+
+TEST_CASE("Tiled triangulations match the global triangulation", "[tiling]") {
+	std::vector<point> points = generate_points(2000, 100);
+	std::vector<triangle> global = delaunay::triangulate(points);
+
+	auto ordered = [](std::vector<triangle> triangles) {
+		std::sort(triangles.begin(), triangles.end(), [](const triangle& a, const triangle& b) {
+			return std::tie(a.a.x, a.a.y, a.b.x, a.b.y, a.c.x, a.c.y) <
+				std::tie(b.a.x, b.a.y, b.b.x, b.b.y, b.c.x, b.c.y);
+		});
+
+		return triangles;
+	};
+
+	std::vector<triangle> tiled = delaunay::triangulate_tiled(points, delaunay::tiling(4, 3, 0.25, 4));
+	REQUIRE(tiled.size() == global.size());
+
+	for(const triangle& t : tiled) {
+		bool found = false;
+		for(const triangle& g : global) {
+			found |= g.has_vertex(t.a) && g.has_vertex(t.b) && g.has_vertex(t.c);
+		}
+
+		REQUIRE(found);
+	}
+
+	// Boundary triangles come out identical whichever tile produced them
+	std::vector<triangle> single = delaunay::triangulate_tiled(points, delaunay::tiling(1, 1));
+	std::vector<triangle> skewed = delaunay::triangulate_tiled(points, delaunay::tiling(7, 2, 0.1, 2));
+
+	REQUIRE(ordered(tiled) == ordered(single));
+	REQUIRE(ordered(skewed) == ordered(single));
+
+	// The steps run apart, as separate workers would, only reading the
+	// buckets they ask for
+	delaunay::tiling grid(4, 3, 0.25);
+	delaunay::tile_plan plan = delaunay::plan_tiles(points, grid);
+	std::vector<std::vector<point>> buckets = delaunay::bucket_points(points, plan);
+
+	std::vector<std::vector<triangle>> results(plan.tile_count());
+	for(size_t tile = results.size(); tile-- > 0;) {
+		results[tile] = delaunay::triangulate_tile(plan, tile, [&](size_t other) -> const std::vector<point>& {
+			return buckets[other];
+		});
+	}
+
+	REQUIRE(delaunay::merge_tiles(results) == tiled);
+
+	// On a lattice, full of cocircular points, tiles still agree on every
+	// diagonal: the triangles cover the convex hull exactly once
+	std::mt19937 gen(8);
+	std::vector<point> lattice;
+	std::set<std::pair<int, int>> seen;
+
+	while(lattice.size() < 1500) {
+		int x = static_cast<int>(gen() % 61), y = static_cast<int>(gen() % 61);
+		if(seen.insert({ x, y }).second) lattice.emplace_back(x, y);
+	}
+
+	auto area = [](const point& a, const point& b, const point& c) {
+		return std::fabs((b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y)) / 2.0;
+	};
+
+	for(double spacing : { 1.0, 0.1 }) {
+		std::vector<point> scaled;
+		for(const point& p : lattice) scaled.emplace_back(p.x * spacing, p.y * spacing);
+
+		std::vector<uint32_t> hull = delaunay::convex_hull(scaled);
+		double hull_area = 0.0;
+		for(size_t i = 1; i + 1 < hull.size(); ++i) {
+			hull_area += area(scaled[hull[0]], scaled[hull[i]], scaled[hull[i + 1]]);
+		}
+
+		std::vector<triangle> single_tile = delaunay::triangulate_tiled(scaled, delaunay::tiling(1, 1));
+
+		for(size_t side = 1; side <= 5; ++side) {
+			std::vector<triangle> lattice_tiled = delaunay::triangulate_tiled(scaled, delaunay::tiling(side, side));
+			REQUIRE(lattice_tiled.size() == single_tile.size());
+
+			double tiled_area = 0.0;
+			for(const triangle& t : lattice_tiled) tiled_area += area(t.a, t.b, t.c);
+			REQUIRE(std::fabs(tiled_area - hull_area) <= 1e-9 * hull_area);
+
+			REQUIRE(ordered(lattice_tiled) == ordered(single_tile));
+		}
+	}
+}
+
+TEST_CASE("Point files are read back", "[io]") {
+	std::filesystem::path dir = std::filesystem::temp_directory_path();
+	std::vector<point> points = generate_points(1000, 10);
+
+	std::string xyz = (dir / "delaunay-test.xyz").string();
+	{
+		std::ofstream out(xyz);
+		out.precision(17);
+		out << "x,y,z\n";
+		for(const point& p : points) out << p.x << "," << p.y << ",1.5\n";
+	}
+
+	std::vector<point> read = delaunay::read_points(xyz, 4);
+	REQUIRE(read.size() == points.size());
+	for(size_t i = 0; i < points.size(); ++i) {
+		REQUIRE(read[i].x == points[i].x);
+		REQUIRE(read[i].y == points[i].y);
+	}
+
+	mesh m = delaunay::triangulate_mesh(points);
+
+	for(bool binary : { true, false }) {
+		std::string ply = (dir / "delaunay-test.ply").string();
+		delaunay::write_ply(m, ply, binary);
+
+		read = delaunay::read_ply(ply, 4);
+		REQUIRE(read.size() == points.size());
+		for(size_t i = 0; i < points.size(); ++i) {
+			REQUIRE(read[i].x == points[i].x);
+			REQUIRE(read[i].y == points[i].y);
+		}
+
+		std::filesystem::remove(ply);
+	}
+
+	// Minimal LAS 1.2 file with point data record format 0
+	std::string las = (dir / "delaunay-test.las").string();
+	{
+		char header[227] = {};
+		std::memcpy(header, "LASF", 4);
+		header[24] = 1;
+		header[25] = 2;
+
+		uint16_t header_size = sizeof(header);
+		uint32_t offset = sizeof(header), count = 3;
+		uint16_t record = 20;
+		double scale = 0.01, origin = 100.0;
+
+		std::memcpy(header + 94, &header_size, 2);
+		std::memcpy(header + 96, &offset, 4);
+		std::memcpy(header + 105, &record, 2);
+		std::memcpy(header + 107, &count, 4);
+		std::memcpy(header + 131, &scale, 8);
+		std::memcpy(header + 139, &scale, 8);
+		std::memcpy(header + 155, &origin, 8);
+		std::memcpy(header + 163, &origin, 8);
+
+		std::ofstream out(las, std::ios::binary);
+		out.write(header, sizeof(header));
+
+		for(int32_t i = 0; i < 3; ++i) {
+			char data[20] = {};
+			int32_t x = 100 * i, y = -50 * i;
+			std::memcpy(data, &x, 4);
+			std::memcpy(data + 4, &y, 4);
+			out.write(data, sizeof(data));
+		}
+	}
+
+	read = delaunay::read_points(las);
+	REQUIRE(read.size() == 3);
+	REQUIRE(read[2].x == 102.0);
+	REQUIRE(read[2].y == 99.0);
+
+	// LAS 1.4 with a 64-bit count whose byte size wraps around
+	{
+		std::fstream file(las, std::ios::binary | std::ios::in | std::ios::out);
+		char minor = 4;
+		uint32_t legacy = 0;
+		uint64_t wrapping = uint64_t(1) << 62;
+
+		file.seekp(25);
+		file.write(&minor, 1);
+		file.seekp(107);
+		file.write(reinterpret_cast<const char*>(&legacy), 4);
+		file.seekp(247);
+		file.write(reinterpret_cast<const char*>(&wrapping), 8);
+	}
+
+	REQUIRE_THROWS_AS(delaunay::read_points(las), std::runtime_error);
+
+	// A skipped PLY element whose byte size wraps around
+	std::string hostile = (dir / "delaunay-hostile.ply").string();
+	{
+		std::ofstream out(hostile, std::ios::binary);
+		out << "ply\nformat binary_little_endian 1.0\n"
+		    << "element face 2305843009213693952\nproperty double a\n"
+		    << "element vertex 1\nproperty double x\nproperty double y\nend_header\n";
+	}
+
+	REQUIRE_THROWS_AS(delaunay::read_ply(hostile), std::runtime_error);
+	std::filesystem::remove(hostile);
+
+	std::string obj = (dir / "delaunay-test.obj").string();
+	delaunay::write_mesh(m, obj);
+	{
+		std::ifstream in(obj);
+		size_t faces = 0;
+		for(std::string line; std::getline(in, line);) faces += line[0] == 'f';
+
+		REQUIRE(faces == m.size());
+	}
+
+	std::filesystem::remove(xyz);
+	std::filesystem::remove(las);
+	std::filesystem::remove(obj);
+}